@@ -0,0 +1,276 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// IPC file format skipping record batches with footer statistics
+
+// This API is EXPERIMENTAL.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/array.h"
+#include "arrow/compute/expression.h"
+#include "arrow/dataset/file_base.h"
+#include "arrow/dataset/file_ipc.h"
+#include "arrow/dataset/scanner.h"
+#include "arrow/dataset/type_fwd.h"
+#include "arrow/ipc/batch_statistics.h"
+#include "arrow/ipc/reader.h"
+#include "arrow/record_batch.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/type.h"
+#include "arrow/util/async_generator.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/iterator.h"
+#include "arrow/util/thread_pool.h"
+
+namespace arrow {
+namespace dataset {
+
+namespace internal {
+
+// For each record batch described by `statistics`, an expression which is
+// true for all its rows, in terms of the fields of `dataset_schema`
+inline std::vector<compute::Expression> BatchStatisticsGuarantees(
+    const RecordBatch& statistics, const Schema& file_schema,
+    const Schema& dataset_schema) {
+  const auto& num_rows =
+      ::arrow::internal::checked_cast<const Int64Array&>(*statistics.column(0));
+  std::vector<std::vector<compute::Expression>> conjunctions(statistics.num_rows());
+  for (int i = 1; i < statistics.num_columns(); ++i) {
+    const auto& statistics_field = statistics.schema()->field(i);
+    if (statistics_field->type()->id() != Type::STRUCT ||
+        statistics_field->type()->num_fields() != 3 ||
+        statistics_field->metadata() == NULLPTR) {
+      continue;
+    }
+    auto maybe_index =
+        statistics_field->metadata()->Get(ipc::kBatchStatisticsColumnIndexKey);
+    if (!maybe_index.ok()) continue;
+    const int column_index = std::atoi(maybe_index->c_str());
+    if (column_index < 0 || column_index >= file_schema.num_fields()) continue;
+    const auto& field = file_schema.field(column_index);
+    // Literals must have the type the filter was bound with
+    auto dataset_field = dataset_schema.GetFieldByName(field->name());
+    if (dataset_field == NULLPTR || !dataset_field->type()->Equals(field->type())) {
+      continue;
+    }
+
+    const auto& column =
+        ::arrow::internal::checked_cast<const StructArray&>(*statistics.column(i));
+    const auto& mins = column.field(0);
+    const auto& maxes = column.field(1);
+    if (!mins->type()->Equals(field->type()) ||
+        column.field(2)->type_id() != Type::INT64) {
+      continue;
+    }
+    const auto& null_counts =
+        ::arrow::internal::checked_cast<const Int64Array&>(*column.field(2));
+    auto ref = compute::field_ref(field->name());
+    for (int64_t batch = 0; batch < statistics.num_rows(); ++batch) {
+      const int64_t null_count = null_counts.Value(batch);
+      if (null_count == num_rows.Value(batch)) {
+        conjunctions[batch].push_back(compute::is_null(ref));
+        continue;
+      }
+      if (mins->IsNull(batch) || maxes->IsNull(batch)) continue;
+      auto min = mins->GetScalar(batch);
+      auto max = maxes->GetScalar(batch);
+      if (!min.ok() || !max.ok()) continue;
+      auto range = compute::and_(compute::greater_equal(ref, compute::literal(*min)),
+                                 compute::less_equal(ref, compute::literal(*max)));
+      if (null_count > 0) range = compute::or_(std::move(range), compute::is_null(ref));
+      conjunctions[batch].push_back(std::move(range));
+    }
+  }
+
+  std::vector<compute::Expression> guarantees;
+  guarantees.reserve(conjunctions.size());
+  for (auto& conjunction : conjunctions) {
+    guarantees.push_back(conjunction.empty() ? compute::literal(true)
+                                             : compute::and_(std::move(conjunction)));
+  }
+  return guarantees;
+}
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: An IpcFileFormat which skips the record batches ruled
+/// out by the scan filter, according to statistics in the file footer
+///
+/// Files written through this format carry per-batch column statistics (see
+/// ipc::StatisticsFileWriter).
+///
+/// When scanning, the statistics of each batch are turned into a guarantee and
+/// the scan filter is simplified against it: batches for which the filter
+/// cannot be satisfied are not read at all.  As with IpcFileFormat, only the
+/// columns materialized by the scan are read from the batches that remain.
+///
+/// Files without statistics are scanned entirely.  The format has the type
+/// name of IpcFileFormat, so IpcFragmentScanOptions and IpcFileWriteOptions
+/// apply to it.
+class IpcStatisticsFileFormat : public IpcFileFormat {
+ public:
+  Result<RecordBatchGenerator> ScanBatchesAsync(
+      const std::shared_ptr<ScanOptions>& options,
+      const std::shared_ptr<FileFragment>& file) const override {
+    ARROW_ASSIGN_OR_RAISE(auto physical_schema, file->ReadPhysicalSchema());
+    ARROW_ASSIGN_OR_RAISE(auto read_options, GetReadOptions(*options, *physical_schema));
+    ARROW_ASSIGN_OR_RAISE(auto input, file->source().Open());
+    ARROW_ASSIGN_OR_RAISE(
+        auto reader, ipc::RecordBatchFileReader::Open(std::move(input), read_options));
+    ARROW_ASSIGN_OR_RAISE(auto batch_indices,
+                          SelectBatches(*reader, *options, *physical_schema));
+
+    size_t next = 0;
+    auto batches = MakeFunctionIterator(
+        [reader, batch_indices = std::move(batch_indices),
+         next]() mutable -> Result<std::shared_ptr<RecordBatch>> {
+          if (next == batch_indices.size()) {
+            return IterationEnd<std::shared_ptr<RecordBatch>>();
+          }
+          return reader->ReadRecordBatch(batch_indices[next++]);
+        });
+    ARROW_ASSIGN_OR_RAISE(auto generator,
+                          MakeBackgroundGenerator(std::move(batches),
+                                                  options->io_context.executor()));
+    return MakeTransferredGenerator(std::move(generator),
+                                    ::arrow::internal::GetCpuThreadPool());
+  }
+
+  Result<std::shared_ptr<FileWriter>> MakeWriter(
+      std::shared_ptr<io::OutputStream> destination, std::shared_ptr<Schema> schema,
+      std::shared_ptr<FileWriteOptions> options,
+      fs::FileLocator destination_locator) const override {
+    if (!Equals(*options->format())) {
+      return Status::TypeError("Mismatching format/write options.");
+    }
+    auto ipc_options =
+        ::arrow::internal::checked_pointer_cast<IpcFileWriteOptions>(options);
+    ARROW_ASSIGN_OR_RAISE(
+        auto writer, ipc::StatisticsFileWriter::Make(destination, schema,
+                                                     *ipc_options->options,
+                                                     ipc_options->metadata));
+    return std::shared_ptr<FileWriter>(new StatisticsFileWriter(
+        std::move(destination), std::move(writer), std::move(schema),
+        std::move(ipc_options), std::move(destination_locator)));
+  }
+
+ private:
+  class StatisticsFileWriter : public FileWriter {
+   public:
+    StatisticsFileWriter(std::shared_ptr<io::OutputStream> destination,
+                         std::shared_ptr<ipc::RecordBatchWriter> writer,
+                         std::shared_ptr<Schema> schema,
+                         std::shared_ptr<IpcFileWriteOptions> options,
+                         fs::FileLocator destination_locator)
+        : FileWriter(std::move(schema), std::move(options), std::move(destination),
+                     std::move(destination_locator)),
+          batch_writer_(std::move(writer)) {}
+
+    Status Write(const std::shared_ptr<RecordBatch>& batch) override {
+      return batch_writer_->WriteRecordBatch(*batch);
+    }
+
+   private:
+    Future<> FinishInternal() override {
+      return Future<>::MakeFinished(batch_writer_->Close());
+    }
+
+    std::shared_ptr<ipc::RecordBatchWriter> batch_writer_;
+  };
+
+  // Reader options reading the materialized fields only, as IpcFileFormat does
+  Result<ipc::IpcReadOptions> GetReadOptions(const ScanOptions& options,
+                                             const Schema& physical_schema) const {
+    auto read_options = ipc::IpcReadOptions::Defaults();
+    auto fragment_scan_options = options.fragment_scan_options
+                                     ? options.fragment_scan_options
+                                     : default_fragment_scan_options;
+    if (fragment_scan_options != NULLPTR) {
+      if (fragment_scan_options->type_name() != type_name()) {
+        return Status::Invalid("FragmentScanOptions of type ",
+                               fragment_scan_options->type_name(),
+                               " were provided for scanning a fragment of type ",
+                               type_name());
+      }
+      const auto& ipc_scan_options =
+          ::arrow::internal::checked_cast<const IpcFragmentScanOptions&>(
+              *fragment_scan_options);
+      if (ipc_scan_options.options) read_options = *ipc_scan_options.options;
+    }
+    read_options.memory_pool = options.pool;
+    read_options.use_threads = false;
+    read_options.included_fields.clear();
+    for (const auto& ref : options.MaterializedFields()) {
+      for (const auto& path : ref.FindAll(physical_schema)) {
+        read_options.included_fields.push_back(path.indices()[0]);
+      }
+    }
+    std::sort(read_options.included_fields.begin(), read_options.included_fields.end());
+    read_options.included_fields.erase(
+        std::unique(read_options.included_fields.begin(),
+                    read_options.included_fields.end()),
+        read_options.included_fields.end());
+    return read_options;
+  }
+
+  // The indices of the batches for which the filter may be satisfied
+  Result<std::vector<int>> SelectBatches(ipc::RecordBatchFileReader& reader,
+                                         const ScanOptions& options,
+                                         const Schema& physical_schema) const {
+    std::vector<int> batch_indices(reader.num_record_batches());
+    for (int i = 0; i < reader.num_record_batches(); ++i) batch_indices[i] = i;
+    if (options.filter == compute::literal(true) || options.dataset_schema == NULLPTR) {
+      return batch_indices;
+    }
+    ARROW_ASSIGN_OR_RAISE(auto statistics, ipc::ReadBatchStatistics(reader.metadata()));
+    if (statistics == NULLPTR ||
+        statistics->num_rows() != reader.num_record_batches()) {
+      return batch_indices;
+    }
+    auto filter = options.filter;
+    if (!filter.IsBound()) {
+      ARROW_ASSIGN_OR_RAISE(filter, filter.Bind(*options.dataset_schema));
+    }
+    auto guarantees = internal::BatchStatisticsGuarantees(*statistics, physical_schema,
+                                                          *options.dataset_schema);
+    batch_indices.clear();
+    for (int i = 0; i < reader.num_record_batches(); ++i) {
+      if (guarantees[i] != compute::literal(true)) {
+        ARROW_ASSIGN_OR_RAISE(auto guarantee,
+                              guarantees[i].Bind(*options.dataset_schema));
+        ARROW_ASSIGN_OR_RAISE(auto simplified,
+                              compute::SimplifyWithGuarantee(filter, guarantee));
+        if (!simplified.IsSatisfiable()) continue;
+      }
+      batch_indices.push_back(i);
+    }
+    return batch_indices;
+  }
+};
+
+}  // namespace dataset
+}  // namespace arrow
@@ -0,0 +1,692 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Persistent listing of the files of a FileSystemDataset
+
+// This API is EXPERIMENTAL.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "arrow/array.h"
+#include "arrow/builder.h"
+#include "arrow/compute/expression.h"
+#include "arrow/dataset/dataset.h"
+#include "arrow/dataset/discovery.h"
+#include "arrow/dataset/file_base.h"
+#include "arrow/dataset/partition.h"
+#include "arrow/dataset/scanner.h"
+#include "arrow/filesystem/filesystem.h"
+#include "arrow/filesystem/path_util.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/io/memory.h"
+#include "arrow/ipc/reader.h"
+#include "arrow/ipc/writer.h"
+#include "arrow/record_batch.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/type.h"
+#include "arrow/util/base64.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/config.h"
+#include "arrow/util/key_value_metadata.h"
+#include "arrow/util/parallel.h"
+
+#ifdef ARROW_PARQUET
+#include "arrow/dataset/file_parquet.h"
+#include "parquet/metadata.h"
+#include "parquet/schema.h"
+#include "parquet/statistics.h"
+#endif
+
+namespace arrow {
+namespace dataset {
+
+/// \defgroup dataset-manifest Dataset manifests
+///
+/// @{
+
+/// \brief Prefix of the schema metadata keys of a manifest file
+static constexpr char kManifestMetadataPrefix[] = "ARROW:dataset:manifest:";
+
+/// \brief Version of the manifest file layout
+static constexpr int kManifestVersion = 1;
+
+struct DatasetManifestOptions {
+  /// Record the number of rows of each file.
+  ///
+  /// Parquet and IPC files are counted from their metadata; other formats may
+  /// have to read each file entirely (see FileFormat::CountRows).
+  bool count_rows = true;
+
+  /// Record min/max/null statistics of the columns of Parquet files, as a
+  /// guarantee expression (see DatasetManifestEntry::statistics).
+  bool collect_statistics = true;
+
+  /// Inspect files on the CPU thread pool rather than one after the other.
+  bool use_threads = true;
+};
+
+/// \brief What a manifest records about a file
+struct DatasetManifestEntry {
+  std::string path;
+  int64_t size = 0;
+  fs::TimePoint mtime = fs::kNoTime;
+  /// The partition expression of the file, as discovered from its path
+  compute::Expression partition_expression = compute::literal(true);
+  /// The number of rows, if counted
+  std::optional<int64_t> num_rows;
+  /// An expression which is true for all rows of the file, derived from column
+  /// statistics; literal(true) if unknown
+  compute::Expression statistics = compute::literal(true);
+
+  /// \brief Whether `info` describes the same version of the file
+  bool IsUpToDate(const fs::FileInfo& info) const {
+    return info.size() == size && info.mtime() == mtime;
+  }
+};
+
+namespace internal {
+
+inline std::string ManifestMetadataKey(const std::string& name) {
+  return kManifestMetadataPrefix + name;
+}
+
+// Whether a path component below `base_dir` starts with one of `prefixes`
+// (see FileSystemFactoryOptions::selector_ignore_prefixes)
+inline bool IsIgnoredByPrefix(const std::string& base_dir, const std::string& path,
+                              const std::vector<std::string>& prefixes) {
+  if (prefixes.empty()) return false;
+  auto relative = fs::internal::RemoveAncestor(base_dir, path);
+  const std::string relative_path(relative ? *relative : std::string_view(path));
+  for (const auto& part : fs::internal::SplitAbstractPath(relative_path)) {
+    for (const auto& prefix : prefixes) {
+      if (!prefix.empty() && part.compare(0, prefix.size(), prefix) == 0) return true;
+    }
+  }
+  return false;
+}
+
+// The regular files selected by `selector`, excluding ignored ones
+inline Result<std::vector<fs::FileInfo>> ListManifestFiles(
+    fs::FileSystem* filesystem, const fs::FileSelector& selector,
+    const std::vector<std::string>& ignore_prefixes) {
+  ARROW_ASSIGN_OR_RAISE(auto infos, filesystem->GetFileInfo(selector));
+  std::vector<fs::FileInfo> files;
+  for (auto& info : infos) {
+    if (info.IsFile() &&
+        !IsIgnoredByPrefix(selector.base_dir, info.path(), ignore_prefixes)) {
+      files.push_back(std::move(info));
+    }
+  }
+  return files;
+}
+
+inline Result<std::string> SerializeManifestSchema(const Schema& schema) {
+  ARROW_ASSIGN_OR_RAISE(auto buffer, ipc::SerializeSchema(schema));
+  return ::arrow::util::base64_encode(std::string_view(*buffer));
+}
+
+inline Result<std::shared_ptr<Schema>> DeserializeManifestSchema(
+    const std::string& encoded) {
+  io::BufferReader reader(Buffer::FromString(::arrow::util::base64_decode(encoded)));
+  ipc::DictionaryMemo memo;
+  return ipc::ReadSchema(&reader, &memo);
+}
+
+#ifdef ARROW_PARQUET
+
+// A guarantee satisfied by all rows of a Parquet file: for each top-level
+// column with statistics in every non-empty row group, the disjunction of its
+// row group statistics
+inline compute::Expression ParquetStatisticsGuarantee(
+    const parquet::FileMetaData& metadata, const Schema& physical_schema) {
+  std::vector<compute::Expression> column_guarantees;
+  for (const auto& field : physical_schema.fields()) {
+    const int column_index = metadata.schema()->ColumnIndex(field->name());
+    if (column_index < 0) continue;
+    std::vector<compute::Expression> row_group_guarantees;
+    bool complete = true;
+    for (int i = 0; i < metadata.num_row_groups() && complete; ++i) {
+      auto row_group = metadata.RowGroup(i);
+      if (row_group->num_rows() == 0) continue;
+      auto column_chunk = row_group->ColumnChunk(column_index);
+      std::shared_ptr<parquet::Statistics> statistics;
+      if (column_chunk->is_stats_set()) statistics = column_chunk->statistics();
+      std::optional<compute::Expression> guarantee;
+      if (statistics) {
+        guarantee = ParquetFileFragment::EvaluateStatisticsAsExpression(*field,
+                                                                        *statistics);
+      }
+      if (guarantee) {
+        row_group_guarantees.push_back(std::move(*guarantee));
+      } else {
+        complete = false;
+      }
+    }
+    if (complete && !row_group_guarantees.empty()) {
+      column_guarantees.push_back(compute::or_(row_group_guarantees));
+    }
+  }
+  if (column_guarantees.empty()) return compute::literal(true);
+  return compute::and_(column_guarantees);
+}
+
+#endif  // ARROW_PARQUET
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: A persistent record of the files of a dataset
+///
+/// FileSystemDatasetFactory lists the whole dataset and inspects file schemas
+/// each time a dataset is opened.  A manifest does that once and records, for
+/// each file, its path, size, modification time, partition expression, row
+/// count and a guarantee derived from column statistics, along with the
+/// dataset and partition schemas.  The manifest can be written to and read
+/// back from an Arrow IPC file, and turned into a FileSystemDataset without
+/// listing or opening any data file.
+///
+/// Refresh() brings the manifest up to date, relisting only the given
+/// directories and inspecting only the files that were added or changed
+/// (according to their size and modification time) since.
+///
+/// The statistics guarantee is folded into the partition expression of the
+/// fragments of ToDataset(), so that scans skip the files it rules out in the
+/// same way they skip partitions.
+///
+/// A manifest is not thread-safe: Refresh() must not run concurrently with
+/// other methods.
+class DatasetManifest {
+ public:
+  /// \brief Build a manifest by listing and inspecting `selector`
+  ///
+  /// As with FileSystemDatasetFactory, a PartitioningFactory in
+  /// `factory_options` is resolved from the listed paths, and
+  /// `partition_base_dir` defaults to the selector's base directory.
+  static Result<std::shared_ptr<DatasetManifest>> Make(
+      std::shared_ptr<fs::FileSystem> filesystem, fs::FileSelector selector,
+      std::shared_ptr<FileFormat> format, FileSystemFactoryOptions factory_options,
+      DatasetManifestOptions options = {}) {
+    if (factory_options.partition_base_dir.empty()) {
+      factory_options.partition_base_dir = selector.base_dir;
+    }
+    std::shared_ptr<DatasetManifest> manifest(
+        new DatasetManifest(std::move(filesystem), std::move(selector), std::move(format),
+                            std::move(factory_options), options));
+    ARROW_ASSIGN_OR_RAISE(
+        auto files, internal::ListManifestFiles(
+                        manifest->filesystem_.get(), manifest->selector_,
+                        manifest->factory_options_.selector_ignore_prefixes));
+    RETURN_NOT_OK(manifest->ResolvePartitioning(files));
+    ARROW_ASSIGN_OR_RAISE(manifest->entries_, manifest->InspectFiles(std::move(files)));
+    return manifest;
+  }
+
+  /// \brief Read a manifest written by Write()
+  ///
+  /// `filesystem`, `format` and `factory_options` describe the dataset, as
+  /// in Make(); they are needed to build the dataset and to refresh the
+  /// manifest.  The format must be of the type the manifest was built with.
+  static Result<std::shared_ptr<DatasetManifest>> Read(
+      const std::shared_ptr<io::RandomAccessFile>& source,
+      std::shared_ptr<fs::FileSystem> filesystem, std::shared_ptr<FileFormat> format,
+      FileSystemFactoryOptions factory_options, DatasetManifestOptions options = {}) {
+    ARROW_ASSIGN_OR_RAISE(auto reader, ipc::RecordBatchFileReader::Open(source));
+    auto metadata = reader->schema()->metadata();
+    if (metadata == NULLPTR) {
+      return Status::Invalid("Not a dataset manifest: missing schema metadata");
+    }
+    auto get = [&](const std::string& name) {
+      return metadata->Get(internal::ManifestMetadataKey(name));
+    };
+    ARROW_ASSIGN_OR_RAISE(auto version, get("version"));
+    if (version != std::to_string(kManifestVersion)) {
+      return Status::NotImplemented("Unsupported dataset manifest version ", version);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto format_name, get("format"));
+    if (format_name != format->type_name()) {
+      return Status::Invalid("Dataset manifest was built for format '", format_name,
+                             "', got '", format->type_name(), "'");
+    }
+
+    fs::FileSelector selector;
+    ARROW_ASSIGN_OR_RAISE(selector.base_dir, get("base_dir"));
+    ARROW_ASSIGN_OR_RAISE(auto recursive, get("recursive"));
+    selector.recursive = recursive == "true";
+    if (factory_options.partition_base_dir.empty()) {
+      ARROW_ASSIGN_OR_RAISE(factory_options.partition_base_dir,
+                            get("partition_base_dir"));
+    }
+    std::shared_ptr<DatasetManifest> manifest(
+        new DatasetManifest(std::move(filesystem), std::move(selector), std::move(format),
+                            std::move(factory_options), options));
+    ARROW_ASSIGN_OR_RAISE(auto schema, get("schema"));
+    ARROW_ASSIGN_OR_RAISE(manifest->schema_, internal::DeserializeManifestSchema(schema));
+    ARROW_ASSIGN_OR_RAISE(auto partition_schema, get("partition_schema"));
+    ARROW_ASSIGN_OR_RAISE(auto partition_fields,
+                          internal::DeserializeManifestSchema(partition_schema));
+    RETURN_NOT_OK(manifest->ResolvePartitioning(partition_fields));
+
+    for (int i = 0; i < reader->num_record_batches(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(auto batch, reader->ReadRecordBatch(i));
+      RETURN_NOT_OK(manifest->AppendEntries(*batch));
+    }
+    return manifest;
+  }
+
+  /// \brief Write the manifest as an Arrow IPC file
+  Status Write(const std::shared_ptr<io::OutputStream>& sink,
+               MemoryPool* pool = default_memory_pool()) const {
+    ARROW_ASSIGN_OR_RAISE(auto batch, ToRecordBatch(pool));
+    auto options = ipc::IpcWriteOptions::Defaults();
+    options.memory_pool = pool;
+    ARROW_ASSIGN_OR_RAISE(auto writer,
+                          ipc::MakeFileWriter(sink, batch->schema(), options));
+    RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+    return writer->Close();
+  }
+
+  /// \brief Bring the manifest up to date with the filesystem
+  ///
+  /// Only `directories`, which must be below the manifest's base directory,
+  /// are relisted; entries elsewhere are kept as they are.  Pass no
+  /// directory to relist the whole dataset.  Files whose size and
+  /// modification time did not change are not inspected again.
+  Status Refresh(const std::vector<std::string>& directories = {}) {
+    std::vector<fs::FileSelector> selectors;
+    if (directories.empty()) {
+      selectors.push_back(selector_);
+    } else {
+      for (const auto& directory : directories) {
+        if (directory != selector_.base_dir &&
+            !fs::internal::IsAncestorOf(selector_.base_dir, directory)) {
+          return Status::Invalid("Cannot refresh '", directory,
+                                 "': not below the manifest's base directory '",
+                                 selector_.base_dir, "'");
+        }
+        fs::FileSelector selector = selector_;
+        selector.base_dir = directory;
+        selector.allow_not_found = true;
+        selectors.push_back(std::move(selector));
+      }
+    }
+
+    auto is_relisted = [&](const std::string& path) {
+      for (const auto& selector : selectors) {
+        if (fs::internal::IsAncestorOf(selector.base_dir, path)) return true;
+      }
+      return false;
+    };
+    std::unordered_map<std::string, DatasetManifestEntry> previous;
+    std::vector<DatasetManifestEntry> entries;
+    for (auto& entry : entries_) {
+      if (is_relisted(entry.path)) {
+        previous.emplace(entry.path, std::move(entry));
+      } else {
+        entries.push_back(std::move(entry));
+      }
+    }
+    entries_.clear();
+
+    std::vector<fs::FileInfo> changed;
+    std::unordered_set<std::string> listed;
+    for (const auto& selector : selectors) {
+      ARROW_ASSIGN_OR_RAISE(auto files,
+                            internal::ListManifestFiles(filesystem_.get(), selector,
+                                                        /*ignore_prefixes=*/{}));
+      for (auto& file : files) {
+        // Ignore prefixes apply to the whole path below the dataset's base
+        if (internal::IsIgnoredByPrefix(selector_.base_dir, file.path(),
+                                        factory_options_.selector_ignore_prefixes) ||
+            !listed.insert(file.path()).second) {
+          continue;
+        }
+        auto it = previous.find(file.path());
+        if (it != previous.end() && it->second.IsUpToDate(file)) {
+          entries.push_back(std::move(it->second));
+        } else {
+          changed.push_back(std::move(file));
+        }
+      }
+    }
+    ARROW_ASSIGN_OR_RAISE(auto inspected, InspectFiles(std::move(changed)));
+    for (auto& entry : inspected) entries.push_back(std::move(entry));
+    entries_ = std::move(entries);
+    return Status::OK();
+  }
+
+  /// \brief Create a FileSystemDataset from the manifest, without IO
+  ///
+  /// \param[in] schema the dataset schema, or nullptr for the manifest's
+  Result<std::shared_ptr<FileSystemDataset>> ToDataset(
+      std::shared_ptr<Schema> schema = NULLPTR,
+      compute::Expression root_partition = compute::literal(true)) const {
+    std::vector<std::shared_ptr<FileFragment>> fragments;
+    fragments.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+      fs::FileInfo info(entry.path, fs::FileType::File);
+      info.set_size(entry.size);
+      info.set_mtime(entry.mtime);
+      auto guarantee = compute::and_(entry.partition_expression, entry.statistics);
+      ARROW_ASSIGN_OR_RAISE(
+          auto fragment,
+          format_->MakeFragment(FileSource(std::move(info), filesystem_),
+                                std::move(guarantee)));
+      fragments.push_back(std::move(fragment));
+    }
+    return FileSystemDataset::Make(schema ? std::move(schema) : schema_,
+                                   std::move(root_partition), format_, filesystem_,
+                                   std::move(fragments), partitioning_);
+  }
+
+  /// \brief The number of rows of the dataset, if all files were counted
+  std::optional<int64_t> CountRows() const {
+    int64_t num_rows = 0;
+    for (const auto& entry : entries_) {
+      if (!entry.num_rows) return std::nullopt;
+      num_rows += *entry.num_rows;
+    }
+    return num_rows;
+  }
+
+  const std::shared_ptr<Schema>& schema() const { return schema_; }
+  const std::shared_ptr<Partitioning>& partitioning() const { return partitioning_; }
+  const std::vector<DatasetManifestEntry>& entries() const { return entries_; }
+  const fs::FileSelector& selector() const { return selector_; }
+  const std::shared_ptr<fs::FileSystem>& filesystem() const { return filesystem_; }
+  const std::shared_ptr<FileFormat>& format() const { return format_; }
+
+ private:
+  DatasetManifest(std::shared_ptr<fs::FileSystem> filesystem, fs::FileSelector selector,
+                  std::shared_ptr<FileFormat> format,
+                  FileSystemFactoryOptions factory_options,
+                  const DatasetManifestOptions& options)
+      : filesystem_(std::move(filesystem)),
+        selector_(std::move(selector)),
+        format_(std::move(format)),
+        factory_options_(std::move(factory_options)),
+        options_(options),
+        scan_options_(std::make_shared<ScanOptions>()) {}
+
+  // Fix the partitioning, so that files added later are parsed with the same
+  // field types as the existing ones
+  Status ResolvePartitioning(const std::vector<fs::FileInfo>& files) {
+    if (factory_options_.partitioning.partitioning()) {
+      partitioning_ = factory_options_.partitioning.partitioning();
+      return Status::OK();
+    }
+    std::vector<std::string> paths;
+    for (const auto& file : files) {
+      if (fs::internal::IsAncestorOf(factory_options_.partition_base_dir, file.path())) {
+        paths.push_back(file.path());
+      }
+    }
+    ARROW_ASSIGN_OR_RAISE(
+        auto partition_schema,
+        factory_options_.partitioning.GetOrInferSchema(
+            StripPrefixAndFilename(paths, factory_options_.partition_base_dir)));
+    return ResolvePartitioning(partition_schema);
+  }
+
+  Status ResolvePartitioning(const std::shared_ptr<Schema>& partition_schema) {
+    if (factory_options_.partitioning.partitioning()) {
+      partitioning_ = factory_options_.partitioning.partitioning();
+    } else {
+      ARROW_ASSIGN_OR_RAISE(
+          partitioning_,
+          factory_options_.partitioning.factory()->Finish(partition_schema));
+    }
+    factory_options_.partitioning = partitioning_;
+    return Status::OK();
+  }
+
+  // Discover the partition expressions of `files`, and the dataset schema if
+  // not known yet, then inspect them
+  Result<std::vector<DatasetManifestEntry>> InspectFiles(
+      std::vector<fs::FileInfo> files) {
+    std::vector<DatasetManifestEntry> entries;
+    if (files.empty() && schema_ != NULLPTR) return entries;
+
+    std::unordered_map<std::string, fs::FileInfo> infos;
+    for (const auto& file : files) infos.emplace(file.path(), file);
+    ARROW_ASSIGN_OR_RAISE(
+        auto factory,
+        FileSystemDatasetFactory::Make(filesystem_, files, format_, factory_options_));
+    FinishOptions finish_options;
+    finish_options.schema = schema_;
+    ARROW_ASSIGN_OR_RAISE(auto dataset, factory->Finish(finish_options));
+    if (schema_ == NULLPTR) schema_ = dataset->schema();
+    ARROW_ASSIGN_OR_RAISE(auto fragment_it, dataset->GetFragments());
+    ARROW_ASSIGN_OR_RAISE(auto fragments, fragment_it.ToVector());
+
+    entries.resize(fragments.size());
+    RETURN_NOT_OK(::arrow::internal::OptionalParallelFor(
+        options_.use_threads, static_cast<int>(fragments.size()), [&](int i) -> Status {
+          auto& fragment =
+              ::arrow::internal::checked_cast<FileFragment&>(*fragments[i]);
+          return InspectFragment(fragment, infos.at(fragment.source().path()),
+                                 &entries[i]);
+        }));
+    return entries;
+  }
+
+  Status InspectFragment(FileFragment& fragment, const fs::FileInfo& info,
+                         DatasetManifestEntry* entry) const {
+    entry->path = info.path();
+    entry->size = info.size();
+    entry->mtime = info.mtime();
+    entry->partition_expression = fragment.partition_expression();
+#ifdef ARROW_PARQUET
+    if (auto parquet_fragment = dynamic_cast<ParquetFileFragment*>(&fragment)) {
+      RETURN_NOT_OK(parquet_fragment->EnsureCompleteMetadata());
+      const auto& metadata = parquet_fragment->metadata();
+      if (options_.count_rows) entry->num_rows = metadata->num_rows();
+      if (options_.collect_statistics) {
+        ARROW_ASSIGN_OR_RAISE(auto physical_schema, fragment.ReadPhysicalSchema());
+        entry->statistics =
+            internal::ParquetStatisticsGuarantee(*metadata, *physical_schema);
+      }
+      return Status::OK();
+    }
+#endif
+    if (options_.count_rows) {
+      ARROW_ASSIGN_OR_RAISE(
+          entry->num_rows,
+          fragment.CountRows(compute::literal(true), scan_options_).result());
+    }
+    return Status::OK();
+  }
+
+  static std::shared_ptr<Schema> EntrySchema() {
+    return ::arrow::schema({
+        field("path", utf8(), /*nullable=*/false),
+        field("size", int64(), /*nullable=*/false),
+        field("mtime", timestamp(TimeUnit::NANO)),
+        field("partition_expression", binary()),
+        field("num_rows", int64()),
+        field("statistics", binary()),
+    });
+  }
+
+  static Status AppendExpression(const compute::Expression& expression,
+                                 BinaryBuilder* builder) {
+    if (expression == compute::literal(true)) return builder->AppendNull();
+    ARROW_ASSIGN_OR_RAISE(auto serialized, compute::Serialize(expression));
+    return builder->Append(serialized->data(), serialized->size());
+  }
+
+  static Result<compute::Expression> GetExpression(const BinaryArray& array,
+                                                   int64_t i) {
+    if (array.IsNull(i)) return compute::literal(true);
+    return compute::Deserialize(
+        SliceBuffer(array.value_data(), array.value_offset(i), array.value_length(i)));
+  }
+
+  Result<std::shared_ptr<RecordBatch>> ToRecordBatch(MemoryPool* pool) const {
+    StringBuilder paths(pool);
+    Int64Builder sizes(pool);
+    TimestampBuilder mtimes(timestamp(TimeUnit::NANO), pool);
+    BinaryBuilder partition_expressions(pool);
+    Int64Builder num_rows(pool);
+    BinaryBuilder statistics(pool);
+    for (const auto& entry : entries_) {
+      RETURN_NOT_OK(paths.Append(entry.path));
+      RETURN_NOT_OK(sizes.Append(entry.size));
+      if (entry.mtime == fs::kNoTime) {
+        RETURN_NOT_OK(mtimes.AppendNull());
+      } else {
+        RETURN_NOT_OK(mtimes.Append(entry.mtime.time_since_epoch().count()));
+      }
+      RETURN_NOT_OK(AppendExpression(entry.partition_expression, &partition_expressions));
+      if (entry.num_rows) {
+        RETURN_NOT_OK(num_rows.Append(*entry.num_rows));
+      } else {
+        RETURN_NOT_OK(num_rows.AppendNull());
+      }
+      RETURN_NOT_OK(AppendExpression(entry.statistics, &statistics));
+    }
+    std::vector<std::shared_ptr<Array>> columns(6);
+    RETURN_NOT_OK(paths.Finish(&columns[0]));
+    RETURN_NOT_OK(sizes.Finish(&columns[1]));
+    RETURN_NOT_OK(mtimes.Finish(&columns[2]));
+    RETURN_NOT_OK(partition_expressions.Finish(&columns[3]));
+    RETURN_NOT_OK(num_rows.Finish(&columns[4]));
+    RETURN_NOT_OK(statistics.Finish(&columns[5]));
+
+    ARROW_ASSIGN_OR_RAISE(auto schema, internal::SerializeManifestSchema(*schema_));
+    ARROW_ASSIGN_OR_RAISE(auto partition_schema,
+                          internal::SerializeManifestSchema(*partitioning_->schema()));
+    auto metadata = std::make_shared<KeyValueMetadata>();
+    auto set = [&](const std::string& name, std::string value) {
+      metadata->Append(internal::ManifestMetadataKey(name), std::move(value));
+    };
+    set("version", std::to_string(kManifestVersion));
+    set("format", format_->type_name());
+    set("base_dir", selector_.base_dir);
+    set("recursive", selector_.recursive ? "true" : "false");
+    set("partition_base_dir", factory_options_.partition_base_dir);
+    set("schema", std::move(schema));
+    set("partition_schema", std::move(partition_schema));
+    return RecordBatch::Make(EntrySchema()->WithMetadata(std::move(metadata)),
+                             static_cast<int64_t>(entries_.size()), std::move(columns));
+  }
+
+  Status AppendEntries(const RecordBatch& batch) {
+    if (!batch.schema()->Equals(*EntrySchema(), /*check_metadata=*/false)) {
+      return Status::Invalid("Unexpected dataset manifest schema: ",
+                             batch.schema()->ToString());
+    }
+    const auto& paths = ::arrow::internal::checked_cast<const StringArray&>(
+        *batch.column(0));
+    const auto& sizes =
+        ::arrow::internal::checked_cast<const Int64Array&>(*batch.column(1));
+    const auto& mtimes =
+        ::arrow::internal::checked_cast<const TimestampArray&>(*batch.column(2));
+    const auto& partition_expressions =
+        ::arrow::internal::checked_cast<const BinaryArray&>(*batch.column(3));
+    const auto& num_rows =
+        ::arrow::internal::checked_cast<const Int64Array&>(*batch.column(4));
+    const auto& statistics =
+        ::arrow::internal::checked_cast<const BinaryArray&>(*batch.column(5));
+    for (int64_t i = 0; i < batch.num_rows(); ++i) {
+      DatasetManifestEntry entry;
+      entry.path = paths.GetString(i);
+      entry.size = sizes.Value(i);
+      if (mtimes.IsValid(i)) {
+        entry.mtime = fs::TimePoint(fs::TimePoint::duration(mtimes.Value(i)));
+      }
+      ARROW_ASSIGN_OR_RAISE(entry.partition_expression,
+                            GetExpression(partition_expressions, i));
+      if (num_rows.IsValid(i)) entry.num_rows = num_rows.Value(i);
+      ARROW_ASSIGN_OR_RAISE(entry.statistics, GetExpression(statistics, i));
+      entries_.push_back(std::move(entry));
+    }
+    return Status::OK();
+  }
+
+  std::shared_ptr<fs::FileSystem> filesystem_;
+  fs::FileSelector selector_;
+  std::shared_ptr<FileFormat> format_;
+  FileSystemFactoryOptions factory_options_;
+  DatasetManifestOptions options_;
+  std::shared_ptr<ScanOptions> scan_options_;
+
+  std::shared_ptr<Schema> schema_;
+  std::shared_ptr<Partitioning> partitioning_;
+  std::vector<DatasetManifestEntry> entries_;
+};
+
+/// \brief EXPERIMENTAL: A DatasetFactory creating datasets from a DatasetManifest
+///
+/// Neither Inspect() nor Finish() list or open files, unless
+/// FinishOptions::validate_fragments is set.
+/// \ingroup dataset-filesystem
+class ManifestDatasetFactory : public DatasetFactory {
+ public:
+  static Result<std::shared_ptr<DatasetFactory>> Make(
+      std::shared_ptr<DatasetManifest> manifest) {
+    return std::shared_ptr<DatasetFactory>(
+        new ManifestDatasetFactory(std::move(manifest)));
+  }
+
+  const std::shared_ptr<DatasetManifest>& manifest() const { return manifest_; }
+
+  Result<std::vector<std::shared_ptr<Schema>>> InspectSchemas(
+      InspectOptions /*options*/) override {
+    return std::vector<std::shared_ptr<Schema>>{manifest_->schema()};
+  }
+
+  Result<std::shared_ptr<Dataset>> Finish(FinishOptions options) override {
+    auto schema = options.schema ? options.schema : manifest_->schema();
+    ARROW_ASSIGN_OR_RAISE(auto dataset, manifest_->ToDataset(schema, root_partition_));
+    if (options.validate_fragments && options.schema) {
+      ARROW_ASSIGN_OR_RAISE(auto fragment_it, dataset->GetFragments());
+      int inspected = 0;
+      for (auto maybe_fragment : fragment_it) {
+        if (options.inspect_options.fragments != InspectOptions::kInspectAllFragments &&
+            inspected++ >= options.inspect_options.fragments) {
+          break;
+        }
+        ARROW_ASSIGN_OR_RAISE(auto fragment, maybe_fragment);
+        ARROW_ASSIGN_OR_RAISE(auto physical_schema, fragment->ReadPhysicalSchema());
+        RETURN_NOT_OK(UnifySchemas({schema, physical_schema}).status());
+      }
+    }
+    return dataset;
+  }
+
+ protected:
+  explicit ManifestDatasetFactory(std::shared_ptr<DatasetManifest> manifest)
+      : manifest_(std::move(manifest)) {}
+
+  std::shared_ptr<DatasetManifest> manifest_;
+};
+
+/// @}
+
+}  // namespace dataset
+}  // namespace arrow
@@ -0,0 +1,601 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// A FileSystem caching the contents of the files of another on local disk
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arrow/buffer.h"
+#include "arrow/filesystem/filesystem.h"
+#include "arrow/filesystem/localfs.h"
+#include "arrow/filesystem/path_util.h"
+#include "arrow/io/concurrency.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/future.h"
+#include "arrow/util/key_value_metadata.h"
+#include "arrow/util/string.h"
+
+namespace arrow {
+namespace fs {
+
+struct LocalBlockCacheOptions {
+  static constexpr int64_t kDefaultBlockSize = 4 << 20;
+  static constexpr int64_t kDefaultCapacity = int64_t(10) << 30;
+
+  /// \brief The local directory holding the cached blocks, as an absolute path
+  ///
+  /// It is created if missing.  Several processes may share the directory:
+  /// blocks written by one are read by the others.
+  std::string directory;
+  /// \brief The size of the blocks files are cached by, except for their last
+  /// block
+  int64_t block_size = kDefaultBlockSize;
+  /// \brief The number of bytes of blocks above which the least recently used
+  /// ones are deleted
+  int64_t capacity = kDefaultCapacity;
+  /// \brief The age, in seconds, past which temporary block files found when
+  /// opening the cache are deleted as left over by a crashed writer
+  ///
+  /// Younger ones may belong to a writer of another process still running.
+  double temporary_file_expiry_seconds = 3600;
+};
+
+/// \brief EXPERIMENTAL: A content store of file blocks on local disk
+///
+/// Blocks are identified by a key naming the file, its version and the block
+/// index.  Each block is stored in its own file, named after a hash of the key
+/// and starting with the key itself so that hash collisions are detected.
+/// Blocks are written to a temporary file then renamed into place, so that
+/// concurrent readers, possibly in other processes, never see partial blocks.
+///
+/// Concurrent requests for a block missing from the store share a single
+/// fetch.  When the blocks exceed the capacity, the least recently used ones
+/// are deleted; blocks written by other processes are only accounted for from
+/// the time this process uses them.  This class is thread-safe.
+class LocalBlockCache {
+ public:
+  using FetchFunction = std::function<Result<std::shared_ptr<Buffer>>()>;
+
+  static Result<std::shared_ptr<LocalBlockCache>> Make(
+      const LocalBlockCacheOptions& options) {
+    if (options.block_size <= 0) {
+      return Status::Invalid("Block size must be positive");
+    }
+    std::shared_ptr<LocalBlockCache> cache(new LocalBlockCache(options));
+    RETURN_NOT_OK(cache->Load());
+    return cache;
+  }
+
+  const LocalBlockCacheOptions& options() const { return options_; }
+  int64_t block_size() const { return options_.block_size; }
+
+  /// \brief The number of bytes of the blocks known to this cache
+  int64_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+  /// \brief The number of blocks served from the store
+  int64_t hits() const { return hits_.load(); }
+  /// \brief The number of blocks fetched
+  int64_t misses() const { return misses_.load(); }
+
+  /// \brief Return the block of `key`, calling `fetch` and storing its result
+  /// if the block is not in the store
+  Result<std::shared_ptr<Buffer>> GetBlock(const std::string& key,
+                                           const FetchFunction& fetch) {
+    const std::string name = BlockName(key);
+    Future<std::shared_ptr<Buffer>> in_flight;
+    bool fetcher = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = in_flight_.find(key);
+      if (it != in_flight_.end()) {
+        in_flight = it->second;
+      } else {
+        in_flight = Future<std::shared_ptr<Buffer>>::Make();
+        in_flight_.emplace(key, in_flight);
+        fetcher = true;
+      }
+    }
+    if (!fetcher) {
+      return in_flight.result();
+    }
+
+    auto result = ReadOrFetch(key, name, fetch);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      in_flight_.erase(key);
+    }
+    in_flight.MarkFinished(result);
+    return result;
+  }
+
+ private:
+  struct Entry {
+    int64_t size;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  static constexpr char kTemporarySuffix[] = ".tmp";
+
+  explicit LocalBlockCache(const LocalBlockCacheOptions& options) : options_(options) {
+    std::random_device device;
+    instance_id_ = (uint64_t(device()) << 32) | device();
+  }
+
+  // Create the directory and account for the blocks it already holds, oldest
+  // first in the eviction order
+  Status Load() {
+    RETURN_NOT_OK(local_fs_.CreateDir(options_.directory));
+    FileSelector selector;
+    selector.base_dir = options_.directory;
+    ARROW_ASSIGN_OR_RAISE(auto infos, local_fs_.GetFileInfo(selector));
+    // Entries are added to the front of the LRU list, so oldest first
+    std::sort(infos.begin(), infos.end(), [](const FileInfo& a, const FileInfo& b) {
+      return a.mtime() < b.mtime();
+    });
+    const auto temporary_expiry =
+        std::chrono::system_clock::now() -
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::duration<double>(options_.temporary_file_expiry_seconds));
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& info : infos) {
+      if (!info.IsFile()) continue;
+      if (::arrow::internal::EndsWith(info.base_name(), kTemporarySuffix)) {
+        if (info.mtime() != kNoTime && info.mtime() < temporary_expiry) {
+          // Left over by a crashed writer
+          ARROW_UNUSED(local_fs_.DeleteFile(info.path()));
+        }
+        continue;
+      }
+      AddEntryNoMutex(info.base_name(), info.size());
+    }
+    EvictNoMutex();
+    return Status::OK();
+  }
+
+  Result<std::shared_ptr<Buffer>> ReadOrFetch(const std::string& key,
+                                              const std::string& name,
+                                              const FetchFunction& fetch) {
+    auto stored = ReadBlock(key, name);
+    if (stored.ok()) {
+      ++hits_;
+      return stored;
+    }
+    ++misses_;
+    ARROW_ASSIGN_OR_RAISE(auto block, fetch());
+    // A failure to store the block must not fail the read
+    ARROW_UNUSED(WriteBlock(key, name, *block));
+    return block;
+  }
+
+  // Read a stored block, failing if it is missing or was stored under another key
+  Result<std::shared_ptr<Buffer>> ReadBlock(const std::string& key,
+                                            const std::string& name) {
+    ARROW_ASSIGN_OR_RAISE(auto file, local_fs_.OpenInputFile(BlockPath(name)));
+    ARROW_ASSIGN_OR_RAISE(auto file_size, file->GetSize());
+    ARROW_ASSIGN_OR_RAISE(auto contents, file->ReadAt(0, file_size));
+    ARROW_UNUSED(file->Close());
+    const int64_t header_size = static_cast<int64_t>(sizeof(uint32_t) + key.size());
+    uint32_t key_size = 0;
+    if (contents->size() >= header_size) {
+      std::memcpy(&key_size, contents->data(), sizeof(key_size));
+    }
+    if (contents->size() < header_size || key_size != key.size() ||
+        std::memcmp(contents->data() + sizeof(key_size), key.data(), key.size()) != 0) {
+      return Status::IOError("Cached block '", name, "' does not match its key");
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(name);
+      if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+      } else {
+        // Stored by another process
+        AddEntryNoMutex(name, file_size);
+        EvictNoMutex();
+      }
+    }
+    return SliceBuffer(std::move(contents), header_size);
+  }
+
+  Status WriteBlock(const std::string& key, const std::string& name,
+                    const Buffer& block) {
+    const std::string path = BlockPath(name);
+    const std::string temporary_path = path + "." +
+                                       std::to_string(instance_id_) + "." +
+                                       std::to_string(++temporary_counter_) +
+                                       kTemporarySuffix;
+    ARROW_ASSIGN_OR_RAISE(auto out, local_fs_.OpenOutputStream(temporary_path));
+    const auto key_size = static_cast<uint32_t>(key.size());
+    Status st = out->Write(&key_size, sizeof(key_size));
+    if (st.ok()) st = out->Write(key.data(), static_cast<int64_t>(key.size()));
+    if (st.ok()) st = out->Write(block.data(), block.size());
+    if (st.ok()) st = out->Close();
+    if (st.ok()) st = local_fs_.Move(temporary_path, path);
+    if (!st.ok()) {
+      ARROW_UNUSED(out->Abort());
+      ARROW_UNUSED(local_fs_.DeleteFile(temporary_path));
+      return st;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it != entries_.end()) {
+      RemoveEntryNoMutex(it);
+    }
+    AddEntryNoMutex(name, static_cast<int64_t>(sizeof(key_size) + key.size()) +
+                              block.size());
+    EvictNoMutex();
+    return Status::OK();
+  }
+
+  void AddEntryNoMutex(const std::string& name, int64_t size) {
+    lru_.push_front(name);
+    entries_[name] = Entry{size, lru_.begin()};
+    size_ += size;
+  }
+
+  void RemoveEntryNoMutex(std::unordered_map<std::string, Entry>::iterator it) {
+    size_ -= it->second.size;
+    lru_.erase(it->second.lru_position);
+    entries_.erase(it);
+  }
+
+  void EvictNoMutex() {
+    while (size_ > options_.capacity && !lru_.empty()) {
+      const std::string name = lru_.back();
+      ARROW_UNUSED(local_fs_.DeleteFile(BlockPath(name)));
+      RemoveEntryNoMutex(entries_.find(name));
+    }
+  }
+
+  std::string BlockPath(const std::string& name) const {
+    return internal::ConcatAbstractPath(options_.directory, name);
+  }
+
+  // A stable 64-bit FNV-1a hash, so that processes agree on block names
+  static std::string BlockName(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 1099511628211ULL;
+    }
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) name[i] = kHexDigits[hash & 0xF];
+    return name;
+  }
+
+  const LocalBlockCacheOptions options_;
+  LocalFileSystem local_fs_;
+  uint64_t instance_id_;
+  std::atomic<uint64_t> temporary_counter_{0};
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+
+  mutable std::mutex mutex_;
+  // Fetches in progress, by block key
+  std::unordered_map<std::string, Future<std::shared_ptr<Buffer>>> in_flight_;
+  // Stored blocks, by name
+  std::unordered_map<std::string, Entry> entries_;
+  // Block names, most recently used first
+  std::list<std::string> lru_;
+  int64_t size_ = 0;
+};
+
+/// \brief EXPERIMENTAL: A RandomAccessFile reading the blocks of another
+/// through a LocalBlockCache
+class CachedRandomAccessFile
+    : public io::internal::RandomAccessFileConcurrencyWrapper<CachedRandomAccessFile> {
+ public:
+  /// \param[in] file the file to cache
+  /// \param[in] cache the store of its blocks
+  /// \param[in] key a key identifying the file and its version
+  /// \param[in] size the size of the file
+  CachedRandomAccessFile(std::shared_ptr<io::RandomAccessFile> file,
+                         std::shared_ptr<LocalBlockCache> cache, std::string key,
+                         int64_t size)
+      : file_(std::move(file)),
+        cache_(std::move(cache)),
+        key_(std::move(key)),
+        size_(size) {}
+
+  bool closed() const override { return closed_; }
+
+  Result<std::shared_ptr<const KeyValueMetadata>> ReadMetadata() override {
+    return file_->ReadMetadata();
+  }
+
+ private:
+  friend RandomAccessFileConcurrencyWrapper<CachedRandomAccessFile>;
+
+  Status CheckClosed() const {
+    if (closed_) {
+      return Status::Invalid("Operation on closed file");
+    }
+    return Status::OK();
+  }
+
+  Status DoClose() {
+    if (closed_) return Status::OK();
+    closed_ = true;
+    return file_->Close();
+  }
+
+  Result<int64_t> DoTell() const {
+    RETURN_NOT_OK(CheckClosed());
+    return position_;
+  }
+
+  Status DoSeek(int64_t position) {
+    RETURN_NOT_OK(CheckClosed());
+    if (position < 0) {
+      return Status::Invalid("Cannot seek to negative position");
+    }
+    position_ = position;
+    return Status::OK();
+  }
+
+  Result<int64_t> DoGetSize() {
+    RETURN_NOT_OK(CheckClosed());
+    return size_;
+  }
+
+  Result<std::shared_ptr<Buffer>> DoReadAt(int64_t position, int64_t nbytes) {
+    RETURN_NOT_OK(CheckClosed());
+    if (position < 0 || nbytes < 0) {
+      return Status::Invalid("Invalid read (offset = ", position, ", size = ", nbytes,
+                             ")");
+    }
+    nbytes = std::min(nbytes, std::max<int64_t>(0, size_ - position));
+    if (nbytes == 0) {
+      return std::make_shared<Buffer>(NULLPTR, 0);
+    }
+    const int64_t block_size = cache_->block_size();
+    const int64_t first_block = position / block_size;
+    const int64_t last_block = (position + nbytes - 1) / block_size;
+    if (first_block == last_block) {
+      ARROW_ASSIGN_OR_RAISE(auto block, GetBlock(first_block));
+      return SliceBufferSafe(std::move(block), position - first_block * block_size,
+                             nbytes);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto out, AllocateBuffer(nbytes, io_context().pool()));
+    RETURN_NOT_OK(DoReadAt(position, nbytes, out->mutable_data()).status());
+    return std::shared_ptr<Buffer>(std::move(out));
+  }
+
+  Result<int64_t> DoReadAt(int64_t position, int64_t nbytes, void* out) {
+    RETURN_NOT_OK(CheckClosed());
+    if (position < 0 || nbytes < 0) {
+      return Status::Invalid("Invalid read (offset = ", position, ", size = ", nbytes,
+                             ")");
+    }
+    nbytes = std::min(nbytes, std::max<int64_t>(0, size_ - position));
+    const int64_t block_size = cache_->block_size();
+    auto* dest = static_cast<uint8_t*>(out);
+    int64_t bytes_read = 0;
+    while (bytes_read < nbytes) {
+      const int64_t offset = position + bytes_read;
+      const int64_t index = offset / block_size;
+      ARROW_ASSIGN_OR_RAISE(auto block, GetBlock(index));
+      const int64_t block_offset = offset - index * block_size;
+      const int64_t n = std::min(nbytes - bytes_read, block->size() - block_offset);
+      if (n <= 0) {
+        return Status::IOError("Cached file '", key_, "' is shorter than its size");
+      }
+      std::memcpy(dest + bytes_read, block->data() + block_offset, n);
+      bytes_read += n;
+    }
+    return bytes_read;
+  }
+
+  Result<int64_t> DoRead(int64_t nbytes, void* out) {
+    ARROW_ASSIGN_OR_RAISE(auto bytes_read, DoReadAt(position_, nbytes, out));
+    position_ += bytes_read;
+    return bytes_read;
+  }
+
+  Result<std::shared_ptr<Buffer>> DoRead(int64_t nbytes) {
+    ARROW_ASSIGN_OR_RAISE(auto buffer, DoReadAt(position_, nbytes));
+    position_ += buffer->size();
+    return buffer;
+  }
+
+  Result<std::shared_ptr<Buffer>> GetBlock(int64_t index) {
+    const int64_t block_size = cache_->block_size();
+    const int64_t offset = index * block_size;
+    const int64_t length = std::min(block_size, size_ - offset);
+    return cache_->GetBlock(key_ + "\n" + std::to_string(index), [&]() {
+      return file_->ReadAt(offset, length);
+    });
+  }
+
+  std::shared_ptr<io::RandomAccessFile> file_;
+  std::shared_ptr<LocalBlockCache> cache_;
+  const std::string key_;
+  const int64_t size_;
+  int64_t position_ = 0;
+  bool closed_ = false;
+};
+
+/// \brief EXPERIMENTAL: A FileSystem implementation that delegates to another
+/// implementation but caches the contents of the files it reads on local disk.
+///
+/// This is useful to read the same objects of a remote filesystem (such as S3
+/// or GCS) repeatedly, for example across the jobs running on a node.  Input
+/// files and streams read their contents by blocks of a LocalBlockCache,
+/// fetching the missing blocks from the base filesystem.
+///
+/// Cached blocks are tied to the version of the file: its ETag, when the
+/// base filesystem reports one in the file metadata (as S3 does), else its
+/// modification time and size.  A modified file is therefore read anew, and
+/// its obsolete blocks are eventually evicted.  Files without either are not
+/// cached.  All other operations are forwarded to the base filesystem.
+class CachingFileSystem : public FileSystem {
+ public:
+  CachingFileSystem(std::shared_ptr<FileSystem> base_fs,
+                    std::shared_ptr<LocalBlockCache> cache)
+      : FileSystem(base_fs->io_context()),
+        base_fs_(std::move(base_fs)),
+        cache_(std::move(cache)) {
+    default_async_is_sync_ = false;
+  }
+
+  std::string type_name() const override { return "caching"; }
+  const std::shared_ptr<FileSystem>& base_fs() const { return base_fs_; }
+  const std::shared_ptr<LocalBlockCache>& cache() const { return cache_; }
+
+  Result<std::string> NormalizePath(std::string path) override {
+    return base_fs_->NormalizePath(std::move(path));
+  }
+  Result<std::string> PathFromUri(const std::string& uri_string) const override {
+    return base_fs_->PathFromUri(uri_string);
+  }
+
+  bool Equals(const FileSystem& other) const override {
+    if (this == &other) return true;
+    if (other.type_name() != type_name()) return false;
+    const auto& caching =
+        ::arrow::internal::checked_cast<const CachingFileSystem&>(other);
+    return cache_ == caching.cache_ && base_fs_->Equals(caching.base_fs_);
+  }
+
+  /// \cond FALSE
+  using FileSystem::GetFileInfo;
+  /// \endcond
+  Result<FileInfo> GetFileInfo(const std::string& path) override {
+    return base_fs_->GetFileInfo(path);
+  }
+  Result<FileInfoVector> GetFileInfo(const FileSelector& select) override {
+    return base_fs_->GetFileInfo(select);
+  }
+  Future<FileInfoVector> GetFileInfoAsync(
+      const std::vector<std::string>& paths) override {
+    return base_fs_->GetFileInfoAsync(paths);
+  }
+  FileInfoGenerator GetFileInfoGenerator(const FileSelector& select) override {
+    return base_fs_->GetFileInfoGenerator(select);
+  }
+
+  Status CreateDir(const std::string& path, bool recursive = true) override {
+    return base_fs_->CreateDir(path, recursive);
+  }
+  Status DeleteDir(const std::string& path) override { return base_fs_->DeleteDir(path); }
+  Status DeleteDirContents(const std::string& path,
+                           bool missing_dir_ok = false) override {
+    return base_fs_->DeleteDirContents(path, missing_dir_ok);
+  }
+  Status DeleteRootDirContents() override { return base_fs_->DeleteRootDirContents(); }
+  Status DeleteFile(const std::string& path) override {
+    return base_fs_->DeleteFile(path);
+  }
+  Status Move(const std::string& src, const std::string& dest) override {
+    return base_fs_->Move(src, dest);
+  }
+  Status CopyFile(const std::string& src, const std::string& dest) override {
+    return base_fs_->CopyFile(src, dest);
+  }
+
+  Result<std::shared_ptr<io::InputStream>> OpenInputStream(
+      const std::string& path) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, OpenInputFile(path));
+    ARROW_ASSIGN_OR_RAISE(auto size, file->GetSize());
+    return io::RandomAccessFile::GetStream(std::move(file), 0, size);
+  }
+  Result<std::shared_ptr<io::InputStream>> OpenInputStream(
+      const FileInfo& info) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, OpenInputFile(info));
+    ARROW_ASSIGN_OR_RAISE(auto size, file->GetSize());
+    return io::RandomAccessFile::GetStream(std::move(file), 0, size);
+  }
+
+  Result<std::shared_ptr<io::RandomAccessFile>> OpenInputFile(
+      const std::string& path) override {
+    ARROW_ASSIGN_OR_RAISE(auto info, base_fs_->GetFileInfo(path));
+    if (!info.IsFile()) {
+      // Let the base filesystem report the error
+      return base_fs_->OpenInputFile(path);
+    }
+    return OpenInputFile(info);
+  }
+
+  Result<std::shared_ptr<io::RandomAccessFile>> OpenInputFile(
+      const FileInfo& info) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, base_fs_->OpenInputFile(info));
+    std::string version;
+    auto metadata = file->ReadMetadata();
+    if (metadata.ok() && *metadata != NULLPTR) {
+      for (int64_t i = 0; i < (*metadata)->size(); ++i) {
+        if (::arrow::internal::AsciiToLower((*metadata)->key(i)) == "etag") {
+          version = "etag " + (*metadata)->value(i);
+          break;
+        }
+      }
+    }
+    int64_t size = info.size();
+    if (size == kNoSize) {
+      ARROW_ASSIGN_OR_RAISE(size, file->GetSize());
+    }
+    if (version.empty()) {
+      if (info.mtime() == kNoTime) {
+        return file;
+      }
+      version = "mtime " + std::to_string(info.mtime().time_since_epoch().count()) +
+                " size " + std::to_string(size);
+    }
+    std::string key = base_fs_->type_name() + "\n" + info.path() + "\n" + version;
+    return std::make_shared<CachedRandomAccessFile>(std::move(file), cache_,
+                                                    std::move(key), size);
+  }
+
+  Result<std::shared_ptr<io::OutputStream>> OpenOutputStream(
+      const std::string& path,
+      const std::shared_ptr<const KeyValueMetadata>& metadata = {}) override {
+    return base_fs_->OpenOutputStream(path, metadata);
+  }
+  Result<std::shared_ptr<io::OutputStream>> OpenAppendStream(
+      const std::string& path,
+      const std::shared_ptr<const KeyValueMetadata>& metadata = {}) override {
+    return base_fs_->OpenAppendStream(path, metadata);
+  }
+
+ private:
+  std::shared_ptr<FileSystem> base_fs_;
+  std::shared_ptr<LocalBlockCache> cache_;
+};
+
+}  // namespace fs
+}  // namespace arrow
@@ -0,0 +1,346 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Recursive listing fanning out over directories concurrently
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/filesystem/filesystem.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/async_generator.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/future.h"
+#include "arrow/util/thread_pool.h"
+
+namespace arrow {
+namespace fs {
+
+struct ParallelListingOptions {
+  static constexpr int kDefaultMaxConcurrentListings = 16;
+
+  /// \brief The maximum number of directories listed concurrently
+  int max_concurrent_listings = kDefaultMaxConcurrentListings;
+};
+
+namespace internal {
+
+// The state of a parallel listing, kept alive by the listings in progress
+class ParallelListing : public std::enable_shared_from_this<ParallelListing> {
+ public:
+  ParallelListing(std::shared_ptr<FileSystem> filesystem, FileSelector selector,
+                  const ParallelListingOptions& options,
+                  PushGenerator<FileInfoVector>::Producer producer)
+      : filesystem_(std::move(filesystem)),
+        selector_(std::move(selector)),
+        max_concurrent_listings_(std::max(options.max_concurrent_listings, 1)),
+        producer_(std::move(producer)) {}
+
+  void Start() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back({selector_.base_dir, 0});
+    }
+    Schedule(/*finished_listing=*/false);
+  }
+
+ private:
+  struct Directory {
+    std::string path;
+    int32_t depth;
+  };
+
+  // Start pending listings up to the concurrency limit and close the
+  // generator once everything was listed
+  void Schedule(bool finished_listing) {
+    std::vector<Directory> to_list;
+    bool done = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (finished_listing) --running_;
+      if (stopped_) {
+        return;
+      }
+      while (running_ < max_concurrent_listings_ && !pending_.empty()) {
+        to_list.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+        ++running_;
+      }
+      done = running_ == 0 && pending_.empty();
+      if (done) stopped_ = true;
+    }
+    for (auto& directory : to_list) {
+      Spawn(std::move(directory));
+    }
+    if (done) {
+      producer_.Close();
+    }
+  }
+
+  // Start a listing on the IO executor rather than in the caller: generators
+  // completing synchronously would otherwise recurse from List() to Schedule()
+  // and back for every directory
+  void Spawn(Directory directory) {
+    auto self = shared_from_this();
+    Status st = filesystem_->io_context().executor()->Spawn(
+        [self, directory = std::move(directory)]() mutable {
+          self->List(std::move(directory));
+        });
+    if (!st.ok()) {
+      Fail(st);
+      Schedule(/*finished_listing=*/true);
+    }
+  }
+
+  void List(Directory directory) {
+    FileSelector selector;
+    selector.base_dir = directory.path;
+    // Subdirectories may vanish between their listing and their parent's
+    selector.allow_not_found = directory.depth > 0 || selector_.allow_not_found;
+    selector.recursive = false;
+    const int32_t depth = directory.depth;
+    auto self = shared_from_this();
+    VisitAsyncGenerator(filesystem_->GetFileInfoGenerator(selector),
+                        [self, depth](const FileInfoVector& infos) {
+                          return self->OnEntries(infos, depth);
+                        })
+        .AddCallback([self](const Status& status) {
+          if (!status.ok()) {
+            self->Fail(status);
+          }
+          self->Schedule(/*finished_listing=*/true);
+        });
+  }
+
+  Status OnEntries(const FileInfoVector& infos, int32_t depth) {
+    if (selector_.recursive && depth < selector_.max_recursion) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& info : infos) {
+        if (info.IsDirectory()) {
+          pending_.push_back({info.path(), depth + 1});
+        }
+      }
+    }
+    if (!producer_.Push(infos)) {
+      // The consumer went away or the listing failed elsewhere
+      return Status::Cancelled("Listing abandoned");
+    }
+    Schedule(/*finished_listing=*/false);
+    return Status::OK();
+  }
+
+  void Fail(const Status& status) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) return;
+      stopped_ = true;
+      pending_.clear();
+    }
+    if (!status.IsCancelled()) {
+      producer_.Push(status);
+    }
+    producer_.Close();
+  }
+
+  std::shared_ptr<FileSystem> filesystem_;
+  const FileSelector selector_;
+  const int max_concurrent_listings_;
+  PushGenerator<FileInfoVector>::Producer producer_;
+
+  std::mutex mutex_;
+  std::deque<Directory> pending_;
+  int running_ = 0;
+  bool stopped_ = false;
+};
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: Stream the entries selected by `selector`, listing
+/// directories concurrently
+///
+/// FileSystem::GetFileInfo(FileSelector) recurses into one directory after
+/// the other, which on object stores means one sequence of paged list
+/// requests per common prefix.  This generator lists each directory with a
+/// non-recursive selector and lists the subdirectories it finds concurrently,
+/// up to `max_concurrent_listings` at a time.  Each page of results is
+/// yielded as soon as it arrives, so consumers can start working before the
+/// listing finishes; entries are in no particular order.
+///
+/// Listing stops early, without error, if the generator is destroyed.
+inline FileInfoGenerator MakeParallelFileInfoGenerator(
+    std::shared_ptr<FileSystem> filesystem, FileSelector selector,
+    const ParallelListingOptions& options = {}) {
+  PushGenerator<FileInfoVector> generator;
+  auto listing = std::make_shared<internal::ParallelListing>(
+      std::move(filesystem), std::move(selector), options, generator.producer());
+  listing->Start();
+  return generator;
+}
+
+/// \brief EXPERIMENTAL: A FileSystem implementation that delegates to another
+/// implementation but lists directories recursively in parallel.
+///
+/// GetFileInfoGenerator() and GetFileInfo(FileSelector) use
+/// MakeParallelFileInfoGenerator(), so that dataset discovery over a
+/// FileSelector (see dataset::FileSystemDatasetFactory) lists large object
+/// store prefixes concurrently.  All other operations are forwarded to the
+/// base filesystem.
+class ParallelListingFileSystem : public FileSystem {
+ public:
+  explicit ParallelListingFileSystem(std::shared_ptr<FileSystem> base_fs,
+                                     const ParallelListingOptions& options = {})
+      : FileSystem(base_fs->io_context()),
+        base_fs_(std::move(base_fs)),
+        options_(options) {
+    default_async_is_sync_ = false;
+  }
+
+  std::string type_name() const override { return "parallel-listing"; }
+  const std::shared_ptr<FileSystem>& base_fs() const { return base_fs_; }
+  const ParallelListingOptions& options() const { return options_; }
+
+  Result<std::string> NormalizePath(std::string path) override {
+    return base_fs_->NormalizePath(std::move(path));
+  }
+  Result<std::string> PathFromUri(const std::string& uri_string) const override {
+    return base_fs_->PathFromUri(uri_string);
+  }
+
+  bool Equals(const FileSystem& other) const override {
+    if (this == &other) return true;
+    if (other.type_name() != type_name()) return false;
+    const auto& parallel =
+        ::arrow::internal::checked_cast<const ParallelListingFileSystem&>(other);
+    return base_fs_->Equals(parallel.base_fs_);
+  }
+
+  /// \cond FALSE
+  using FileSystem::GetFileInfo;
+  /// \endcond
+  Result<FileInfo> GetFileInfo(const std::string& path) override {
+    return base_fs_->GetFileInfo(path);
+  }
+  Result<FileInfoVector> GetFileInfo(const FileSelector& select) override {
+    if (!select.recursive) {
+      return base_fs_->GetFileInfo(select);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto chunks,
+                          CollectAsyncGenerator(GetFileInfoGenerator(select)).result());
+    FileInfoVector infos;
+    for (auto& chunk : chunks) {
+      std::move(chunk.begin(), chunk.end(), std::back_inserter(infos));
+    }
+    return infos;
+  }
+  Future<FileInfoVector> GetFileInfoAsync(
+      const std::vector<std::string>& paths) override {
+    return base_fs_->GetFileInfoAsync(paths);
+  }
+  FileInfoGenerator GetFileInfoGenerator(const FileSelector& select) override {
+    if (!select.recursive) {
+      return base_fs_->GetFileInfoGenerator(select);
+    }
+    return MakeParallelFileInfoGenerator(base_fs_, select, options_);
+  }
+
+  Status CreateDir(const std::string& path, bool recursive = true) override {
+    return base_fs_->CreateDir(path, recursive);
+  }
+  Status DeleteDir(const std::string& path) override { return base_fs_->DeleteDir(path); }
+  Status DeleteDirContents(const std::string& path,
+                           bool missing_dir_ok = false) override {
+    return base_fs_->DeleteDirContents(path, missing_dir_ok);
+  }
+  Future<> DeleteDirContentsAsync(const std::string& path,
+                                  bool missing_dir_ok = false) override {
+    return base_fs_->DeleteDirContentsAsync(path, missing_dir_ok);
+  }
+  Status DeleteRootDirContents() override { return base_fs_->DeleteRootDirContents(); }
+  Status DeleteFile(const std::string& path) override {
+    return base_fs_->DeleteFile(path);
+  }
+  Status DeleteFiles(const std::vector<std::string>& paths) override {
+    return base_fs_->DeleteFiles(paths);
+  }
+  Status Move(const std::string& src, const std::string& dest) override {
+    return base_fs_->Move(src, dest);
+  }
+  Status CopyFile(const std::string& src, const std::string& dest) override {
+    return base_fs_->CopyFile(src, dest);
+  }
+
+  Result<std::shared_ptr<io::InputStream>> OpenInputStream(
+      const std::string& path) override {
+    return base_fs_->OpenInputStream(path);
+  }
+  Result<std::shared_ptr<io::InputStream>> OpenInputStream(
+      const FileInfo& info) override {
+    return base_fs_->OpenInputStream(info);
+  }
+  Result<std::shared_ptr<io::RandomAccessFile>> OpenInputFile(
+      const std::string& path) override {
+    return base_fs_->OpenInputFile(path);
+  }
+  Result<std::shared_ptr<io::RandomAccessFile>> OpenInputFile(
+      const FileInfo& info) override {
+    return base_fs_->OpenInputFile(info);
+  }
+  Future<std::shared_ptr<io::InputStream>> OpenInputStreamAsync(
+      const std::string& path) override {
+    return base_fs_->OpenInputStreamAsync(path);
+  }
+  Future<std::shared_ptr<io::InputStream>> OpenInputStreamAsync(
+      const FileInfo& info) override {
+    return base_fs_->OpenInputStreamAsync(info);
+  }
+  Future<std::shared_ptr<io::RandomAccessFile>> OpenInputFileAsync(
+      const std::string& path) override {
+    return base_fs_->OpenInputFileAsync(path);
+  }
+  Future<std::shared_ptr<io::RandomAccessFile>> OpenInputFileAsync(
+      const FileInfo& info) override {
+    return base_fs_->OpenInputFileAsync(info);
+  }
+
+  Result<std::shared_ptr<io::OutputStream>> OpenOutputStream(
+      const std::string& path,
+      const std::shared_ptr<const KeyValueMetadata>& metadata = {}) override {
+    return base_fs_->OpenOutputStream(path, metadata);
+  }
+  Result<std::shared_ptr<io::OutputStream>> OpenAppendStream(
+      const std::string& path,
+      const std::shared_ptr<const KeyValueMetadata>& metadata = {}) override {
+    return base_fs_->OpenAppendStream(path, metadata);
+  }
+
+ private:
+  std::shared_ptr<FileSystem> base_fs_;
+  const ParallelListingOptions options_;
+};
+
+}  // namespace fs
+}  // namespace arrow
@@ -0,0 +1,522 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Parallel transfers of large objects to and from S3
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "arrow/buffer.h"
+#include "arrow/filesystem/filesystem.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/io/readahead.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/future.h"
+
+namespace arrow {
+namespace fs {
+
+/// Options for S3TransferFileSystem
+struct S3TransferOptions {
+  /// The smallest part size S3 accepts for multipart uploads, except for the last part
+  static constexpr int64_t kMinUploadPartSize = 5 << 20;
+  /// The largest part size S3 accepts
+  static constexpr int64_t kMaxUploadPartSize = int64_t(5) << 30;
+  /// Upload part sizes double every this many parts, so that the 10000 parts
+  /// S3 allows cover the largest objects
+  static constexpr int64_t kUploadPartsPerSizeStep = 1000;
+
+  /// \brief The maximum number of ranged GETs kept in flight per input stream
+  int download_concurrency = 8;
+  /// \brief The bounds of the size of ranged GETs of input streams
+  ///
+  /// The size is tuned between them from the measured latency and throughput
+  /// of the filesystem (see io::AdaptiveReadaheadPolicy).
+  int64_t min_download_part_size = 1 << 20;
+  int64_t max_download_part_size = 64 << 20;
+
+  /// \brief The size of the first parts of multipart uploads
+  int64_t upload_part_size = 16 << 20;
+  /// \brief The number of parts an output stream uploads concurrently before
+  /// waiting for them to complete
+  ///
+  /// Uploads are only concurrent with S3Options::background_writes enabled.
+  int upload_concurrency = 8;
+
+  /// \brief The maximum number of requests in flight on the whole filesystem,
+  /// or 0 for no limit
+  int max_concurrent_requests = 0;
+  /// \brief The maximum transfer rate of the whole filesystem in bytes per
+  /// second, or 0 for no limit
+  int64_t max_bandwidth = 0;
+
+  static S3TransferOptions Defaults() { return {}; }
+};
+
+/// \brief EXPERIMENTAL: Concurrency and bandwidth limits shared by the
+/// transfers of a filesystem
+///
+/// Acquire() blocks while `max_concurrent_requests` requests are in flight,
+/// and Throttle() paces transfers to `max_bandwidth` bytes per second,
+/// allowing bursts of up to one second worth of data.  This class is
+/// thread-safe.
+class TransferBudget {
+ public:
+  TransferBudget(int max_concurrent_requests, int64_t max_bandwidth)
+      : max_concurrent_requests_(max_concurrent_requests),
+        max_bandwidth_(max_bandwidth),
+        next_transfer_(Clock::now()) {}
+
+  int max_concurrent_requests() const { return max_concurrent_requests_; }
+  int64_t max_bandwidth() const { return max_bandwidth_; }
+
+  /// \brief Wait for a request slot
+  void Acquire() {
+    if (max_concurrent_requests_ <= 0) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_freed_.wait(lock, [&] { return in_flight_ < max_concurrent_requests_; });
+    ++in_flight_;
+  }
+
+  void Release() {
+    if (max_concurrent_requests_ <= 0) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --in_flight_;
+    }
+    slot_freed_.notify_one();
+  }
+
+  /// \brief Wait until `nbytes` may be transferred
+  void Throttle(int64_t nbytes) {
+    if (max_bandwidth_ <= 0 || nbytes <= 0) return;
+    Clock::time_point start;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto now = Clock::now();
+      start = std::max(next_transfer_, now - std::chrono::seconds(1));
+      next_transfer_ = start + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(
+                                       static_cast<double>(nbytes) / max_bandwidth_));
+    }
+    std::this_thread::sleep_until(start);
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  const int max_concurrent_requests_;
+  const int64_t max_bandwidth_;
+  std::mutex mutex_;
+  std::condition_variable slot_freed_;
+  int in_flight_ = 0;
+  Clock::time_point next_transfer_;
+};
+
+/// \brief EXPERIMENTAL: A RandomAccessFile whose reads are subject to a
+/// TransferBudget
+///
+/// All other methods are forwarded to the wrapped file.
+class BudgetedRandomAccessFile : public io::RandomAccessFile {
+ public:
+  BudgetedRandomAccessFile(std::shared_ptr<io::RandomAccessFile> file,
+                           std::shared_ptr<TransferBudget> budget)
+      : file_(std::move(file)), budget_(std::move(budget)) {}
+
+  Status Close() override { return file_->Close(); }
+  Future<> CloseAsync() override { return file_->CloseAsync(); }
+  Status Abort() override { return file_->Abort(); }
+  bool closed() const override { return file_->closed(); }
+  Result<int64_t> Tell() const override { return file_->Tell(); }
+  Status Seek(int64_t position) override { return file_->Seek(position); }
+  Result<int64_t> GetSize() override { return file_->GetSize(); }
+  Result<std::string_view> Peek(int64_t nbytes) override { return file_->Peek(nbytes); }
+  bool supports_zero_copy() const override { return file_->supports_zero_copy(); }
+  const io::IOContext& io_context() const override { return file_->io_context(); }
+  Status WillNeed(const std::vector<io::ReadRange>& ranges) override {
+    return file_->WillNeed(ranges);
+  }
+
+  Result<std::shared_ptr<const KeyValueMetadata>> ReadMetadata() override {
+    return file_->ReadMetadata();
+  }
+  using io::RandomAccessFile::ReadMetadataAsync;
+  Future<std::shared_ptr<const KeyValueMetadata>> ReadMetadataAsync(
+      const io::IOContext& io_context) override {
+    return file_->ReadMetadataAsync(io_context);
+  }
+
+  // ReadAsync() and ReadManyAsync() keep their default implementations, which
+  // call ReadAt() on the IO executor.
+
+  Result<int64_t> Read(int64_t nbytes, void* out) override {
+    Request request(budget_.get(), nbytes);
+    return file_->Read(nbytes, out);
+  }
+  Result<std::shared_ptr<Buffer>> Read(int64_t nbytes) override {
+    Request request(budget_.get(), nbytes);
+    return file_->Read(nbytes);
+  }
+  Result<int64_t> ReadAt(int64_t position, int64_t nbytes, void* out) override {
+    Request request(budget_.get(), nbytes);
+    return file_->ReadAt(position, nbytes, out);
+  }
+  Result<std::shared_ptr<Buffer>> ReadAt(int64_t position, int64_t nbytes) override {
+    Request request(budget_.get(), nbytes);
+    return file_->ReadAt(position, nbytes);
+  }
+
+ private:
+  // Holds a request slot of the budget for the duration of a read
+  class Request {
+   public:
+    Request(TransferBudget* budget, int64_t nbytes) : budget_(budget) {
+      budget_->Acquire();
+      budget_->Throttle(nbytes);
+    }
+    ~Request() { budget_->Release(); }
+
+   private:
+    TransferBudget* budget_;
+  };
+
+  std::shared_ptr<io::RandomAccessFile> file_;
+  std::shared_ptr<TransferBudget> budget_;
+};
+
+/// \brief EXPERIMENTAL: An OutputStream writing to an S3 object stream in
+/// large parts
+///
+/// Writes are gathered into parts of `upload_part_size` bytes, doubling
+/// every S3TransferOptions::kUploadPartsPerSizeStep parts, and each part is
+/// handed to the wrapped stream in a single write, which the S3 filesystem
+/// uploads as one part of the multipart upload, in the background with
+/// S3Options::background_writes.  After `upload_concurrency` parts the stream
+/// flushes the wrapped stream, waiting for the uploads in flight, which bounds
+/// the memory held by an upload.
+///
+/// Each part holds a request slot of the TransferBudget while it is handed
+/// over, and its transfer is throttled to the budget's bandwidth.  No slot is
+/// held between writes, so idle streams never block other transfers of the
+/// filesystem; the uploads running in the background are bounded by
+/// `upload_concurrency` per stream instead.
+///
+/// Flush() only waits for the parts already handed over: the last part is
+/// written on Close().
+class MultipartUploadStream : public io::OutputStream {
+ public:
+  MultipartUploadStream(std::shared_ptr<io::OutputStream> raw,
+                        const S3TransferOptions& options,
+                        std::shared_ptr<TransferBudget> budget, MemoryPool* pool)
+      : raw_(std::move(raw)),
+        budget_(std::move(budget)),
+        pool_(pool),
+        part_size_(std::min(
+            std::max(options.upload_part_size, S3TransferOptions::kMinUploadPartSize),
+            S3TransferOptions::kMaxUploadPartSize)),
+        upload_concurrency_(std::max(options.upload_concurrency, 1)) {}
+
+  ~MultipartUploadStream() override {
+    if (!closed_) {
+      ARROW_UNUSED(Close());
+    }
+  }
+
+  /// \brief The size of the next part
+  int64_t part_size() const { return part_size_; }
+
+  /// \brief The number of parts handed to the wrapped stream
+  int64_t num_parts() const { return num_parts_; }
+
+  bool closed() const override { return closed_; }
+
+  Result<int64_t> Tell() const override {
+    RETURN_NOT_OK(CheckClosed());
+    return position_;
+  }
+
+  Status Write(const void* data, int64_t nbytes) override {
+    RETURN_NOT_OK(CheckClosed());
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (nbytes > 0) {
+      if (part_ == NULLPTR) {
+        ARROW_ASSIGN_OR_RAISE(part_, AllocateResizableBuffer(part_size_, pool_));
+        RETURN_NOT_OK(part_->Resize(0, /*shrink_to_fit=*/false));
+      }
+      const int64_t chunk = std::min(nbytes, part_size_ - part_->size());
+      const int64_t old_size = part_->size();
+      RETURN_NOT_OK(part_->Resize(old_size + chunk, /*shrink_to_fit=*/false));
+      std::memcpy(part_->mutable_data() + old_size, bytes, chunk);
+      bytes += chunk;
+      nbytes -= chunk;
+      position_ += chunk;
+      if (part_->size() == part_size_) {
+        RETURN_NOT_OK(WritePart(std::move(part_)));
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Write(const std::shared_ptr<Buffer>& data) override {
+    RETURN_NOT_OK(CheckClosed());
+    // Hand whole parts of large buffers over without copying them
+    int64_t offset = 0;
+    while (part_ == NULLPTR && data->size() - offset >= part_size_) {
+      const int64_t size = part_size_;
+      RETURN_NOT_OK(WritePart(SliceBuffer(data, offset, size)));
+      offset += size;
+      position_ += size;
+    }
+    return Write(data->data() + offset, data->size() - offset);
+  }
+
+  Status Flush() override {
+    RETURN_NOT_OK(CheckClosed());
+    return FlushParts();
+  }
+
+  Status Close() override {
+    if (closed_) return Status::OK();
+    Status st;
+    if (part_ != NULLPTR && part_->size() > 0) {
+      st = WritePart(std::move(part_));
+    }
+    part_.reset();
+    closed_ = true;
+    parts_in_flight_ = 0;
+    if (!st.ok()) {
+      ARROW_UNUSED(raw_->Abort());
+      return st;
+    }
+    return raw_->Close();
+  }
+
+  Status Abort() override {
+    if (closed_) return Status::OK();
+    closed_ = true;
+    part_.reset();
+    parts_in_flight_ = 0;
+    return raw_->Abort();
+  }
+
+ private:
+  Status CheckClosed() const {
+    if (closed_) {
+      return Status::Invalid("Operation on closed stream");
+    }
+    return Status::OK();
+  }
+
+  Status WritePart(std::shared_ptr<Buffer> part) {
+    budget_->Acquire();
+    budget_->Throttle(part->size());
+    Status st = raw_->Write(std::move(part));
+    budget_->Release();
+    RETURN_NOT_OK(st);
+    if (++num_parts_ % S3TransferOptions::kUploadPartsPerSizeStep == 0) {
+      part_size_ = std::min(part_size_ * 2, S3TransferOptions::kMaxUploadPartSize);
+    }
+    if (++parts_in_flight_ >= upload_concurrency_) {
+      return FlushParts();
+    }
+    return Status::OK();
+  }
+
+  // Wait for the parts in flight
+  Status FlushParts() {
+    parts_in_flight_ = 0;
+    return raw_->Flush();
+  }
+
+  std::shared_ptr<io::OutputStream> raw_;
+  std::shared_ptr<TransferBudget> budget_;
+  MemoryPool* pool_;
+  int64_t part_size_;
+  const int upload_concurrency_;
+  std::shared_ptr<ResizableBuffer> part_;
+  int64_t num_parts_ = 0;
+  // Parts handed over since the last flush
+  int parts_in_flight_ = 0;
+  int64_t position_ = 0;
+  bool closed_ = false;
+};
+
+/// \brief EXPERIMENTAL: A FileSystem implementation that delegates to an
+/// S3FileSystem (or another object store) but transfers large objects in
+/// parallel.
+///
+/// - Input streams read ahead with up to `download_concurrency` concurrent
+///   ranged GETs, sized by an io::AdaptiveReadaheadPolicy shared by all the
+///   streams of the filesystem.
+/// - Output streams upload large parts, several at a time (see
+///   MultipartUploadStream).
+/// - All reads and uploads go through a TransferBudget bounding the requests
+///   in flight and the bandwidth of the whole filesystem.
+///
+/// Concurrent requests run on the IO thread pool: its capacity (see
+/// io::SetIOThreadPoolCapacity()) must be at least the desired concurrency.
+/// All other operations are forwarded to the base filesystem.
+class S3TransferFileSystem : public FileSystem {
+ public:
+  explicit S3TransferFileSystem(
+      std::shared_ptr<FileSystem> base_fs,
+      const S3TransferOptions& options = S3TransferOptions::Defaults())
+      : FileSystem(base_fs->io_context()),
+        base_fs_(std::move(base_fs)),
+        options_(options),
+        budget_(std::make_shared<TransferBudget>(options.max_concurrent_requests,
+                                                 options.max_bandwidth)) {
+    readahead_options_.min_block_size = options.min_download_part_size;
+    readahead_options_.max_block_size = options.max_download_part_size;
+    readahead_options_.initial_block_size =
+        std::max(options.min_download_part_size,
+                 std::min<int64_t>(8 << 20, options.max_download_part_size));
+    readahead_options_.max_in_flight = std::max(options.download_concurrency, 1);
+    download_policy_ = std::make_shared<io::AdaptiveReadaheadPolicy>(readahead_options_);
+    default_async_is_sync_ = false;
+  }
+
+  std::string type_name() const override { return "s3transfer"; }
+  const std::shared_ptr<FileSystem>& base_fs() const { return base_fs_; }
+  const S3TransferOptions& options() const { return options_; }
+  const std::shared_ptr<TransferBudget>& budget() const { return budget_; }
+  const std::shared_ptr<io::AdaptiveReadaheadPolicy>& download_policy() const {
+    return download_policy_;
+  }
+
+  Result<std::string> NormalizePath(std::string path) override {
+    return base_fs_->NormalizePath(std::move(path));
+  }
+  Result<std::string> PathFromUri(const std::string& uri_string) const override {
+    return base_fs_->PathFromUri(uri_string);
+  }
+
+  bool Equals(const FileSystem& other) const override {
+    if (this == &other) return true;
+    if (other.type_name() != type_name()) return false;
+    const auto& transfer =
+        ::arrow::internal::checked_cast<const S3TransferFileSystem&>(other);
+    return budget_ == transfer.budget_ && base_fs_->Equals(transfer.base_fs_);
+  }
+
+  /// \cond FALSE
+  using FileSystem::GetFileInfo;
+  /// \endcond
+  Result<FileInfo> GetFileInfo(const std::string& path) override {
+    return base_fs_->GetFileInfo(path);
+  }
+  Result<FileInfoVector> GetFileInfo(const FileSelector& select) override {
+    return base_fs_->GetFileInfo(select);
+  }
+  Future<FileInfoVector> GetFileInfoAsync(
+      const std::vector<std::string>& paths) override {
+    return base_fs_->GetFileInfoAsync(paths);
+  }
+  FileInfoGenerator GetFileInfoGenerator(const FileSelector& select) override {
+    return base_fs_->GetFileInfoGenerator(select);
+  }
+
+  Status CreateDir(const std::string& path, bool recursive = true) override {
+    return base_fs_->CreateDir(path, recursive);
+  }
+  Status DeleteDir(const std::string& path) override { return base_fs_->DeleteDir(path); }
+  Status DeleteDirContents(const std::string& path,
+                           bool missing_dir_ok = false) override {
+    return base_fs_->DeleteDirContents(path, missing_dir_ok);
+  }
+  Future<> DeleteDirContentsAsync(const std::string& path,
+                                  bool missing_dir_ok = false) override {
+    return base_fs_->DeleteDirContentsAsync(path, missing_dir_ok);
+  }
+  Status DeleteRootDirContents() override { return base_fs_->DeleteRootDirContents(); }
+  Status DeleteFile(const std::string& path) override {
+    return base_fs_->DeleteFile(path);
+  }
+  Status Move(const std::string& src, const std::string& dest) override {
+    return base_fs_->Move(src, dest);
+  }
+  Status CopyFile(const std::string& src, const std::string& dest) override {
+    return base_fs_->CopyFile(src, dest);
+  }
+
+  Result<std::shared_ptr<io::InputStream>> OpenInputStream(
+      const std::string& path) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, OpenInputFile(path));
+    return ReadAhead(std::move(file));
+  }
+  Result<std::shared_ptr<io::InputStream>> OpenInputStream(
+      const FileInfo& info) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, OpenInputFile(info));
+    return ReadAhead(std::move(file));
+  }
+
+  Result<std::shared_ptr<io::RandomAccessFile>> OpenInputFile(
+      const std::string& path) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, base_fs_->OpenInputFile(path));
+    return std::make_shared<BudgetedRandomAccessFile>(std::move(file), budget_);
+  }
+  Result<std::shared_ptr<io::RandomAccessFile>> OpenInputFile(
+      const FileInfo& info) override {
+    ARROW_ASSIGN_OR_RAISE(auto file, base_fs_->OpenInputFile(info));
+    return std::make_shared<BudgetedRandomAccessFile>(std::move(file), budget_);
+  }
+
+  Result<std::shared_ptr<io::OutputStream>> OpenOutputStream(
+      const std::string& path,
+      const std::shared_ptr<const KeyValueMetadata>& metadata = {}) override {
+    ARROW_ASSIGN_OR_RAISE(auto raw, base_fs_->OpenOutputStream(path, metadata));
+    return std::make_shared<MultipartUploadStream>(std::move(raw), options_, budget_,
+                                                   io_context().pool());
+  }
+  Result<std::shared_ptr<io::OutputStream>> OpenAppendStream(
+      const std::string& path,
+      const std::shared_ptr<const KeyValueMetadata>& metadata = {}) override {
+    return base_fs_->OpenAppendStream(path, metadata);
+  }
+
+ private:
+  Result<std::shared_ptr<io::InputStream>> ReadAhead(
+      std::shared_ptr<io::RandomAccessFile> file) {
+    ARROW_ASSIGN_OR_RAISE(auto stream, io::AdaptiveReadaheadInputStream::Make(
+                                           std::move(file), io_context(),
+                                           readahead_options_, download_policy_));
+    return stream;
+  }
+
+  std::shared_ptr<FileSystem> base_fs_;
+  const S3TransferOptions options_;
+  std::shared_ptr<TransferBudget> budget_;
+  io::AdaptiveReadaheadOptions readahead_options_;
+  std::shared_ptr<io::AdaptiveReadaheadPolicy> download_policy_;
+};
+
+}  // namespace fs
+}  // namespace arrow
@@ -45,6 +45,7 @@ struct ARROW_EXPORT CacheOptions {
   bool lazy;
   /// \brief The maximum number of ranges to be prefetched. This is only used
   ///   for lazy cache to asynchronously read some ranges after reading the target range.
+  ///   PrefetchingInputStream also uses it as the number of reads kept in flight.
   int64_t prefetch_limit = 0;
 
   bool operator==(const CacheOptions& other) const {
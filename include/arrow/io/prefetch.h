@@ -0,0 +1,387 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Streaming read-ahead over a byte range of a RandomAccessFile
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "arrow/buffer.h"
+#include "arrow/io/caching.h"
+#include "arrow/io/concurrency.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/future.h"
+#include "arrow/util/macros.h"
+
+namespace arrow {
+namespace io {
+
+/// \brief EXPERIMENTAL: A memory limit shared by several prefetching streams
+///
+/// Each PrefetchingInputStream reserves the size of a read before issuing it.
+/// The reservation is released once the data is no longer referenced, by the
+/// stream or by the zero-copy buffers it returned.  A stream may exceed the
+/// limit by one read when it has nothing else buffered, so that every stream
+/// can make progress however small the limit.  This class is thread-safe.
+class PrefetchBudget {
+ public:
+  explicit PrefetchBudget(int64_t limit) : limit_(limit) {}
+
+  int64_t limit() const { return limit_; }
+
+  /// \brief The number of bytes currently reserved
+  int64_t used() const { return used_.load(); }
+
+  /// \brief Reserve `nbytes` if that keeps usage within the limit
+  bool TryReserve(int64_t nbytes) {
+    int64_t used = used_.load();
+    do {
+      if (used + nbytes > limit_) {
+        return false;
+      }
+    } while (!used_.compare_exchange_weak(used, used + nbytes));
+    return true;
+  }
+
+  /// \brief Reserve `nbytes` regardless of the limit
+  void ForceReserve(int64_t nbytes) { used_ += nbytes; }
+
+  void Release(int64_t nbytes) { used_ -= nbytes; }
+
+ private:
+  const int64_t limit_;
+  std::atomic<int64_t> used_{0};
+};
+
+namespace internal {
+
+// A buffer returning its reservation to a PrefetchBudget when destroyed, that
+// is once the slices handed out from it are gone as well
+class BudgetedBuffer : public Buffer {
+ public:
+  BudgetedBuffer(const std::shared_ptr<Buffer>& buffer,
+                 std::shared_ptr<PrefetchBudget> budget, int64_t reserved)
+      : Buffer(buffer, 0, buffer->size()),
+        budget_(std::move(budget)),
+        reserved_(reserved) {}
+
+  ~BudgetedBuffer() override {
+    if (budget_ != NULLPTR) {
+      budget_->Release(reserved_);
+    }
+  }
+
+ private:
+  std::shared_ptr<PrefetchBudget> budget_;
+  int64_t reserved_;
+};
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: An InputStream over a byte range of a file that reads
+/// ahead asynchronously
+///
+/// The range is read in requests of at most CacheOptions::range_size_limit
+/// bytes, and up to CacheOptions::prefetch_limit of them (at least one) are
+/// kept in flight ahead of the reader through RandomAccessFile::ReadAsync.
+/// Unlike ReadRangeCache, which holds entire ranges until the cache is
+/// destroyed, the memory held by a stream is bounded by its window and data is
+/// released as soon as it is consumed.  When several streams share a
+/// PrefetchBudget, read-ahead is also paused while the budget is exhausted.
+///
+/// Read(nbytes) and Peek() are zero-copy unless they straddle two requests.
+///
+/// This is a standalone stream: the compiled Parquet reader does not create
+/// it, ReaderProperties::GetStream() still returns buffered or whole-chunk
+/// streams.
+class PrefetchingInputStream
+    : public internal::InputStreamConcurrencyWrapper<PrefetchingInputStream> {
+ public:
+  ~PrefetchingInputStream() override { ReleaseAll(); }
+
+  /// \brief Create a stream over [offset, offset + length) of `file`
+  ///
+  /// The first requests are issued before returning.
+  static Result<std::shared_ptr<PrefetchingInputStream>> Make(
+      std::shared_ptr<RandomAccessFile> file, const IOContext& io_context,
+      int64_t offset, int64_t length, const CacheOptions& options,
+      std::shared_ptr<PrefetchBudget> budget = NULLPTR) {
+    if (offset < 0 || length < 0) {
+      return Status::Invalid("Invalid prefetch range: offset ", offset, ", length ",
+                             length);
+    }
+    if (options.range_size_limit <= 0) {
+      return Status::Invalid("range_size_limit must be positive");
+    }
+    std::shared_ptr<PrefetchingInputStream> stream(new PrefetchingInputStream(
+        std::move(file), io_context, offset, length, options, std::move(budget)));
+    stream->FillWindow();
+    return stream;
+  }
+
+  bool closed() const override { return closed_; }
+
+  const IOContext& io_context() const override { return io_context_; }
+
+  bool supports_zero_copy() const override { return true; }
+
+  /// \brief The number of requests currently in flight
+  int64_t requests_in_flight() const {
+    return static_cast<int64_t>(pending_.size());
+  }
+
+ private:
+  friend InputStreamConcurrencyWrapper<PrefetchingInputStream>;
+
+  struct PendingRead {
+    Future<std::shared_ptr<Buffer>> future;
+    int64_t offset;
+    int64_t size;
+  };
+
+  PrefetchingInputStream(std::shared_ptr<RandomAccessFile> file,
+                         const IOContext& io_context, int64_t offset, int64_t length,
+                         const CacheOptions& options,
+                         std::shared_ptr<PrefetchBudget> budget)
+      : file_(std::move(file)),
+        io_context_(io_context),
+        start_(offset),
+        end_(offset + length),
+        next_read_(offset),
+        request_size_(options.range_size_limit),
+        max_in_flight_(std::max<int64_t>(options.prefetch_limit, 1)),
+        budget_(std::move(budget)) {}
+
+  Status DoClose() {
+    ReleaseAll();
+    closed_ = true;
+    return Status::OK();
+  }
+
+  Result<int64_t> DoTell() const {
+    RETURN_NOT_OK(CheckClosed());
+    return position_;
+  }
+
+  Result<int64_t> DoRead(int64_t nbytes, void* out) {
+    RETURN_NOT_OK(CheckClosed());
+    auto* dest = static_cast<uint8_t*>(out);
+    int64_t bytes_read = 0;
+    while (bytes_read < nbytes) {
+      if (available() == 0) {
+        RETURN_NOT_OK(NextBuffer());
+        if (available() == 0) break;
+      }
+      const int64_t chunk = std::min(nbytes - bytes_read, available());
+      std::memcpy(dest + bytes_read, current_->data() + current_position_, chunk);
+      Consume(chunk);
+      bytes_read += chunk;
+    }
+    return bytes_read;
+  }
+
+  Result<std::shared_ptr<Buffer>> DoRead(int64_t nbytes) {
+    RETURN_NOT_OK(CheckClosed());
+    RETURN_NOT_OK(EnsureContiguous(nbytes));
+    nbytes = std::min(nbytes, available());
+    auto out = current_ != NULLPTR ? SliceBuffer(current_, current_position_, nbytes)
+                                   : std::make_shared<Buffer>(NULLPTR, 0);
+    Consume(nbytes);
+    return out;
+  }
+
+  Result<std::string_view> DoPeek(int64_t nbytes) override {
+    RETURN_NOT_OK(CheckClosed());
+    RETURN_NOT_OK(EnsureContiguous(nbytes));
+    if (current_ == NULLPTR) {
+      return std::string_view();
+    }
+    return std::string_view(
+        reinterpret_cast<const char*>(current_->data() + current_position_),
+        static_cast<size_t>(std::min(nbytes, available())));
+  }
+
+  Status CheckClosed() const {
+    if (closed_) {
+      return Status::Invalid("Operation on closed stream");
+    }
+    return Status::OK();
+  }
+
+  int64_t available() const {
+    return current_ != NULLPTR ? current_->size() - current_position_ : 0;
+  }
+
+  void Consume(int64_t nbytes) {
+    current_position_ += nbytes;
+    position_ += nbytes;
+  }
+
+  void Release(int64_t nbytes) {
+    if (budget_ != NULLPTR) {
+      budget_->Release(nbytes);
+    }
+  }
+
+  // Issue reads until the window is full, the range is exhausted or the budget
+  // runs out
+  void FillWindow() {
+    while (next_read_ < end_ && static_cast<int64_t>(pending_.size()) < max_in_flight_) {
+      const int64_t size = std::min(request_size_, end_ - next_read_);
+      if (budget_ != NULLPTR && !budget_->TryReserve(size)) {
+        if (!pending_.empty() || available() > 0) break;
+        budget_->ForceReserve(size);
+      }
+      pending_.push_back(
+          {file_->ReadAsync(io_context_, next_read_, size), next_read_, size});
+      next_read_ += size;
+    }
+  }
+
+  // Wait for the oldest pending read.  On failure, the pending reads are
+  // dropped and the stream rewinds to the failed read, so that a retry issues
+  // it again instead of skipping its range.
+  Result<std::shared_ptr<Buffer>> WaitOldest() {
+    PendingRead read = std::move(pending_.front());
+    pending_.pop_front();
+    auto maybe_buffer = read.future.result();
+    Status status = maybe_buffer.status();
+    if (status.ok() && (*maybe_buffer)->size() != read.size) {
+      status = Status::IOError("Unexpected end of file: expected ", read.size,
+                               " bytes at offset ", read.offset, ", got ",
+                               (*maybe_buffer)->size());
+    }
+    if (!status.ok()) {
+      Release(read.size);
+      DropPending();
+      next_read_ = read.offset;
+      return status;
+    }
+    return Budgeted(*maybe_buffer, read.size);
+  }
+
+  std::shared_ptr<Buffer> Budgeted(const std::shared_ptr<Buffer>& buffer,
+                                   int64_t reserved) {
+    if (budget_ == NULLPTR) {
+      return buffer;
+    }
+    return std::make_shared<internal::BudgetedBuffer>(buffer, budget_, reserved);
+  }
+
+  // Wait for the oldest pending read and make it the current buffer
+  Status NextBuffer() {
+    current_.reset();
+    current_position_ = 0;
+    FillWindow();
+    if (pending_.empty()) {
+      return Status::OK();
+    }
+    ARROW_ASSIGN_OR_RAISE(current_, WaitOldest());
+    FillWindow();
+    return Status::OK();
+  }
+
+  // Make at least `nbytes` bytes (or whatever remains of the range) available
+  // in the current buffer, merging pending reads into it if needed
+  Status EnsureContiguous(int64_t nbytes) {
+    if (available() == 0) {
+      RETURN_NOT_OK(NextBuffer());
+    }
+    nbytes = std::min(nbytes, end_ - start_ - position_);
+    if (available() >= nbytes) {
+      return Status::OK();
+    }
+    // The current buffer is only replaced once all reads succeeded
+    ARROW_ASSIGN_OR_RAISE(auto merged,
+                          AllocateResizableBuffer(available(), io_context_.pool()));
+    std::memcpy(merged->mutable_data(), current_->data() + current_position_,
+                available());
+    while (merged->size() < nbytes) {
+      if (pending_.empty()) {
+        FillWindow();
+        if (pending_.empty()) break;
+      }
+      auto maybe_buffer = WaitOldest();
+      if (!maybe_buffer.ok()) {
+        // The reads merged so far are discarded along with `merged`
+        next_read_ = start_ + position_ + available();
+        return maybe_buffer.status();
+      }
+      const auto& buffer = *maybe_buffer;
+      const int64_t old_size = merged->size();
+      RETURN_NOT_OK(merged->Resize(old_size + buffer->size()));
+      std::memcpy(merged->mutable_data() + old_size, buffer->data(), buffer->size());
+    }
+    // The merged copy is accounted for on its own: the reads it was made from
+    // are released once nothing else references them
+    const int64_t merged_size = merged->size();
+    ForceReserve(merged_size);
+    current_ = Budgeted(std::move(merged), merged_size);
+    current_position_ = 0;
+    FillWindow();
+    return Status::OK();
+  }
+
+  void ForceReserve(int64_t nbytes) {
+    if (budget_ != NULLPTR) {
+      budget_->ForceReserve(nbytes);
+    }
+  }
+
+  void DropPending() {
+    for (const auto& read : pending_) {
+      Release(read.size);
+    }
+    pending_.clear();
+  }
+
+  void ReleaseAll() {
+    current_.reset();
+    DropPending();
+    next_read_ = end_;
+  }
+
+  std::shared_ptr<RandomAccessFile> file_;
+  IOContext io_context_;
+  const int64_t start_;
+  const int64_t end_;
+  int64_t next_read_;
+  const int64_t request_size_;
+  const int64_t max_in_flight_;
+  std::shared_ptr<PrefetchBudget> budget_;
+
+  std::deque<PendingRead> pending_;
+  std::shared_ptr<Buffer> current_;
+  int64_t current_position_ = 0;
+  // Position relative to the start of the range
+  int64_t position_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace io
+}  // namespace arrow
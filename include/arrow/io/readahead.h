@@ -0,0 +1,466 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Read-ahead with request sizes adapted to the measured latency and throughput
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#include "arrow/buffer.h"
+#include "arrow/io/concurrency.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/future.h"
+#include "arrow/util/thread_pool.h"
+
+namespace arrow {
+namespace io {
+
+struct AdaptiveReadaheadOptions {
+  /// \brief The size of the first requests
+  int64_t initial_block_size = 1 << 20;
+  /// \brief The bounds of the request size
+  int64_t min_block_size = 64 << 10;
+  int64_t max_block_size = 64 << 20;
+  /// \brief The maximum number of requests kept ahead of the reader
+  int max_in_flight = 4;
+  /// \brief The fraction of the time of a request that may be spent on its
+  /// fixed latency (time to first byte) rather than on transferring data
+  ///
+  /// Lower values make requests larger on high-latency filesystems.
+  double latency_overhead = 0.1;
+
+  static AdaptiveReadaheadOptions Defaults() { return {}; }
+};
+
+/// \brief EXPERIMENTAL: Chooses read sizes from the measured cost of reads
+///
+/// The time of a read of n bytes is modelled as `latency + n / bandwidth`,
+/// fitted by least squares over the recorded reads, older reads weighing
+/// exponentially less so that the model follows changing conditions.  The
+/// block size is then the size at which latency accounts for
+/// `latency_overhead` of the read time: large on object stores with tens of
+/// milliseconds to first byte, small on local disks.  The block size changes
+/// by at most a factor of two per read, and successive reads alternate
+/// slightly above and below it so that the fit stays well conditioned.
+///
+/// This class is thread-safe.
+class AdaptiveReadaheadPolicy {
+ public:
+  explicit AdaptiveReadaheadPolicy(
+      const AdaptiveReadaheadOptions& options = AdaptiveReadaheadOptions::Defaults())
+      : options_(options),
+        target_block_size_(Clamp(options.initial_block_size)),
+        block_size_(target_block_size_) {}
+
+  /// \brief The size of the next read
+  int64_t block_size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return block_size_;
+  }
+
+  /// \brief The estimated latency of a read in seconds, 0 if unknown
+  double latency() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latency_;
+  }
+
+  /// \brief The estimated bandwidth in bytes per second, 0 if unknown
+  double bandwidth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bandwidth_;
+  }
+
+  /// \brief Record that reading `nbytes` bytes took `seconds`
+  void Record(int64_t nbytes, double seconds) {
+    if (nbytes <= 0 || seconds < 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double x = static_cast<double>(nbytes);
+    weight_ = weight_ * kDecay + 1;
+    sum_x_ = sum_x_ * kDecay + x;
+    sum_y_ = sum_y_ * kDecay + seconds;
+    sum_xx_ = sum_xx_ * kDecay + x * x;
+    sum_xy_ = sum_xy_ * kDecay + x * seconds;
+
+    const double mean_x = sum_x_ / weight_;
+    const double mean_y = sum_y_ / weight_;
+    const double var_x = sum_xx_ / weight_ - mean_x * mean_x;
+    const double cov_xy = sum_xy_ / weight_ - mean_x * mean_y;
+    double target = static_cast<double>(target_block_size_);
+    // Wait for reads of different sizes to separate latency from bandwidth
+    if (var_x > kMinRelativeSpread * mean_x * mean_x) {
+      const double seconds_per_byte = cov_xy / var_x;
+      if (seconds_per_byte > 0) {
+        latency_ = std::max(0.0, mean_y - seconds_per_byte * mean_x);
+        bandwidth_ = 1 / seconds_per_byte;
+        const double overhead = std::min(std::max(options_.latency_overhead, 0.01), 0.99);
+        target = latency_ * bandwidth_ * (1 - overhead) / overhead;
+      } else {
+        // Read time does not grow with the size: latency-bound
+        target *= 2;
+      }
+    }
+    const double current = static_cast<double>(target_block_size_);
+    target = std::min(std::max(target, current / 2), current * 2);
+    target_block_size_ = Clamp(static_cast<int64_t>(target));
+    dither_up_ = !dither_up_;
+    block_size_ = Clamp(dither_up_ ? target_block_size_ * 5 / 4
+                                   : target_block_size_ * 4 / 5);
+  }
+
+ private:
+  static constexpr double kDecay = 0.8;
+  static constexpr double kMinRelativeSpread = 0.0025;
+
+  int64_t Clamp(int64_t size) const {
+    return std::max(options_.min_block_size,
+                    std::min(std::max(size, int64_t(1)), options_.max_block_size));
+  }
+
+  const AdaptiveReadaheadOptions options_;
+  mutable std::mutex mutex_;
+  int64_t target_block_size_;
+  int64_t block_size_;
+  bool dither_up_ = false;
+  double latency_ = 0;
+  double bandwidth_ = 0;
+  // Exponentially weighted sums over (read size, read time)
+  double weight_ = 0;
+  double sum_x_ = 0;
+  double sum_y_ = 0;
+  double sum_xx_ = 0;
+  double sum_xy_ = 0;
+};
+
+/// \brief EXPERIMENTAL: An InputStream reading ahead of its consumer in requests
+/// sized by an AdaptiveReadaheadPolicy
+///
+/// If the wrapped stream is a RandomAccessFile, up to `max_in_flight` requests
+/// are issued concurrently as RandomAccessFile::ReadAt calls on the IOContext's
+/// executor, from its current position to its end.  Any other stream is read
+/// sequentially on that executor, keeping up to `max_in_flight` requests queued,
+/// until a read returns no data.
+///
+/// The number of requests kept ahead starts at one and grows whenever the
+/// consumer has to wait for data, then shrinks back after the consumer found
+/// data ready for a while.  Read(nbytes) and Peek() are zero-copy unless they
+/// straddle two requests.  Wrapping the input of a reader that consumes fixed
+/// blocks (such as the CSV and JSON readers) adapts its actual reads.
+class AdaptiveReadaheadInputStream
+    : public internal::InputStreamConcurrencyWrapper<AdaptiveReadaheadInputStream> {
+ public:
+  /// \brief Wrap `raw`, sharing `policy` with other streams if given
+  static Result<std::shared_ptr<AdaptiveReadaheadInputStream>> Make(
+      std::shared_ptr<InputStream> raw,
+      const IOContext& io_context = io::default_io_context(),
+      const AdaptiveReadaheadOptions& options = AdaptiveReadaheadOptions::Defaults(),
+      std::shared_ptr<AdaptiveReadaheadPolicy> policy = NULLPTR) {
+    if (options.min_block_size <= 0 || options.max_block_size < options.min_block_size) {
+      return Status::Invalid("Invalid read-ahead block size bounds");
+    }
+    if (policy == NULLPTR) {
+      policy = std::make_shared<AdaptiveReadaheadPolicy>(options);
+    }
+    std::shared_ptr<AdaptiveReadaheadInputStream> stream(new AdaptiveReadaheadInputStream(
+        std::move(raw), io_context, options, std::move(policy)));
+    ARROW_ASSIGN_OR_RAISE(stream->start_, stream->raw_->Tell());
+    stream->next_read_ = stream->start_;
+    if (stream->file_ != NULLPTR) {
+      ARROW_ASSIGN_OR_RAISE(stream->end_, stream->file_->GetSize());
+    }
+    stream->FillWindow();
+    return stream;
+  }
+
+  bool closed() const override { return closed_; }
+
+  const IOContext& io_context() const override { return io_context_; }
+
+  bool supports_zero_copy() const override { return true; }
+
+  const std::shared_ptr<AdaptiveReadaheadPolicy>& policy() const { return policy_; }
+
+  /// \brief The number of requests currently kept ahead of the consumer
+  int64_t window() const { return window_; }
+
+ private:
+  friend InputStreamConcurrencyWrapper<AdaptiveReadaheadInputStream>;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct PendingRead {
+    Future<std::shared_ptr<Buffer>> future;
+    int64_t size;
+  };
+
+  // Shrink the window after this many consumed requests in a row were ready
+  static constexpr int kReadyRequestsBeforeShrink = 8;
+
+  AdaptiveReadaheadInputStream(std::shared_ptr<InputStream> raw,
+                               const IOContext& io_context,
+                               const AdaptiveReadaheadOptions& options,
+                               std::shared_ptr<AdaptiveReadaheadPolicy> policy)
+      : raw_(std::move(raw)),
+        file_(std::dynamic_pointer_cast<RandomAccessFile>(raw_)),
+        io_context_(io_context),
+        max_window_(std::max(options.max_in_flight, 1)),
+        policy_(std::move(policy)) {}
+
+  Status DoClose() {
+    if (closed_) return Status::OK();
+    closed_ = true;
+    // Let reads in flight finish before closing the stream under them
+    for (const auto& read : pending_) read.future.Wait();
+    pending_.clear();
+    current_.reset();
+    return raw_->Close();
+  }
+
+  Status DoAbort() {
+    if (closed_) return Status::OK();
+    closed_ = true;
+    for (const auto& read : pending_) read.future.Wait();
+    pending_.clear();
+    current_.reset();
+    return raw_->Abort();
+  }
+
+  Result<int64_t> DoTell() const {
+    RETURN_NOT_OK(CheckClosed());
+    return start_ + position_;
+  }
+
+  Result<int64_t> DoRead(int64_t nbytes, void* out) {
+    RETURN_NOT_OK(CheckClosed());
+    auto* dest = static_cast<uint8_t*>(out);
+    int64_t bytes_read = 0;
+    while (bytes_read < nbytes) {
+      if (available() == 0) {
+        RETURN_NOT_OK(NextBuffer());
+        if (available() == 0) break;
+      }
+      const int64_t chunk = std::min(nbytes - bytes_read, available());
+      std::memcpy(dest + bytes_read, current_->data() + current_position_, chunk);
+      Consume(chunk);
+      bytes_read += chunk;
+    }
+    return bytes_read;
+  }
+
+  Result<std::shared_ptr<Buffer>> DoRead(int64_t nbytes) {
+    RETURN_NOT_OK(CheckClosed());
+    RETURN_NOT_OK(EnsureContiguous(nbytes));
+    nbytes = std::min(nbytes, available());
+    auto out = current_ != NULLPTR ? SliceBuffer(current_, current_position_, nbytes)
+                                   : std::make_shared<Buffer>(NULLPTR, 0);
+    Consume(nbytes);
+    return out;
+  }
+
+  Result<std::string_view> DoPeek(int64_t nbytes) override {
+    RETURN_NOT_OK(CheckClosed());
+    RETURN_NOT_OK(EnsureContiguous(nbytes));
+    if (current_ == NULLPTR) {
+      return std::string_view();
+    }
+    return std::string_view(
+        reinterpret_cast<const char*>(current_->data() + current_position_),
+        static_cast<size_t>(std::min(nbytes, available())));
+  }
+
+  Status CheckClosed() const {
+    if (closed_) {
+      return Status::Invalid("Operation on closed stream");
+    }
+    return Status::OK();
+  }
+
+  int64_t available() const {
+    return current_ != NULLPTR ? current_->size() - current_position_ : 0;
+  }
+
+  void Consume(int64_t nbytes) {
+    current_position_ += nbytes;
+    position_ += nbytes;
+  }
+
+  bool exhausted() const { return eof_ || (file_ != NULLPTR && next_read_ >= end_); }
+
+  // Issue reads until the window is full or the stream is exhausted
+  void FillWindow() {
+    while (!exhausted() && static_cast<int64_t>(pending_.size()) < window_) {
+      int64_t size = policy_->block_size();
+      if (file_ != NULLPTR) {
+        size = std::min(size, end_ - next_read_);
+      }
+      pending_.push_back({IssueRead(size), size});
+      next_read_ += size;
+    }
+  }
+
+  Future<std::shared_ptr<Buffer>> IssueRead(int64_t size) {
+    auto policy = policy_;
+    if (file_ != NULLPTR) {
+      // Time the read itself, not the wait for an executor thread
+      auto read_at = [file = file_, policy, offset = next_read_,
+                      size]() -> Result<std::shared_ptr<Buffer>> {
+        const auto start = Clock::now();
+        ARROW_ASSIGN_OR_RAISE(auto buffer, file->ReadAt(offset, size));
+        policy->Record(buffer->size(), Seconds(start));
+        return buffer;
+      };
+      return DeferNotOk(
+          io_context_.executor()->Submit(io_context_.stop_token(), std::move(read_at)));
+    }
+    // Reads of a plain stream must not overlap: chain each after the previous
+    auto read = [raw = raw_, policy, size]() -> Result<std::shared_ptr<Buffer>> {
+      const auto start = Clock::now();
+      ARROW_ASSIGN_OR_RAISE(auto buffer, raw->Read(size));
+      policy->Record(buffer->size(), Seconds(start));
+      return buffer;
+    };
+    if (!last_sequential_read_.is_valid()) {
+      last_sequential_read_ = DeferNotOk(io_context_.executor()->Submit(std::move(read)));
+    } else {
+      CallbackOptions options;
+      options.should_schedule = ShouldSchedule::Always;
+      options.executor = io_context_.executor();
+      last_sequential_read_ = last_sequential_read_.Then(
+          [read](const std::shared_ptr<Buffer>&) { return read(); }, {}, options);
+    }
+    return last_sequential_read_;
+  }
+
+  static double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  // Wait for the oldest pending read and make it the current buffer
+  Status NextBuffer() {
+    current_.reset();
+    current_position_ = 0;
+    FillWindow();
+    if (pending_.empty()) {
+      return Status::OK();
+    }
+    PendingRead read = std::move(pending_.front());
+    pending_.pop_front();
+    AdjustWindow(read.future.is_finished());
+    ARROW_ASSIGN_OR_RAISE(current_, read.future.result());
+    RETURN_NOT_OK(CheckReadSize(read, *current_));
+    FillWindow();
+    return Status::OK();
+  }
+
+  Status CheckReadSize(const PendingRead& read, const Buffer& buffer) {
+    if (buffer.size() == read.size) {
+      return Status::OK();
+    }
+    if (file_ != NULLPTR) {
+      return Status::IOError("Unexpected end of file: expected ", read.size,
+                             " bytes at offset ", start_ + position_, ", got ",
+                             buffer.size());
+    }
+    // A plain stream may return less than requested before its end; only an
+    // empty read marks the end (the reads queued after it return nothing too)
+    if (buffer.size() == 0) {
+      eof_ = true;
+    }
+    return Status::OK();
+  }
+
+  // Keep more requests ahead when the consumer waits for data, fewer when it
+  // keeps finding data ready
+  void AdjustWindow(bool ready) {
+    if (!ready) {
+      window_ = std::min(window_ + 1, max_window_);
+      ready_in_a_row_ = 0;
+    } else if (++ready_in_a_row_ >= kReadyRequestsBeforeShrink) {
+      window_ = std::max<int64_t>(window_ - 1, 1);
+      ready_in_a_row_ = 0;
+    }
+  }
+
+  // Make at least `nbytes` bytes (or whatever remains of the stream) available
+  // in the current buffer, merging pending reads into it if needed
+  Status EnsureContiguous(int64_t nbytes) {
+    if (available() == 0) {
+      RETURN_NOT_OK(NextBuffer());
+    }
+    if (available() >= nbytes || current_ == NULLPTR) {
+      return Status::OK();
+    }
+    ARROW_ASSIGN_OR_RAISE(auto merged,
+                          AllocateResizableBuffer(available(), io_context_.pool()));
+    std::memcpy(merged->mutable_data(), current_->data() + current_position_,
+                available());
+    while (merged->size() < nbytes) {
+      if (pending_.empty()) {
+        FillWindow();
+        if (pending_.empty()) break;
+      }
+      PendingRead read = std::move(pending_.front());
+      pending_.pop_front();
+      AdjustWindow(read.future.is_finished());
+      ARROW_ASSIGN_OR_RAISE(auto buffer, read.future.result());
+      RETURN_NOT_OK(CheckReadSize(read, *buffer));
+      const int64_t old_size = merged->size();
+      RETURN_NOT_OK(merged->Resize(old_size + buffer->size()));
+      std::memcpy(merged->mutable_data() + old_size, buffer->data(), buffer->size());
+    }
+    current_ = std::move(merged);
+    current_position_ = 0;
+    FillWindow();
+    return Status::OK();
+  }
+
+  std::shared_ptr<InputStream> raw_;
+  // Same as raw_ if it supports positional reads
+  std::shared_ptr<RandomAccessFile> file_;
+  IOContext io_context_;
+  const int64_t max_window_;
+  std::shared_ptr<AdaptiveReadaheadPolicy> policy_;
+
+  int64_t start_ = 0;
+  int64_t end_ = 0;
+  int64_t next_read_ = 0;
+  bool eof_ = false;
+  Future<std::shared_ptr<Buffer>> last_sequential_read_;
+
+  std::deque<PendingRead> pending_;
+  int64_t window_ = 1;
+  int ready_in_a_row_ = 0;
+  std::shared_ptr<Buffer> current_;
+  int64_t current_position_ = 0;
+  // Position relative to start_
+  int64_t position_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace io
+}  // namespace arrow
@@ -0,0 +1,858 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Streams through a ring buffer in shared memory, for zero-copy IPC between
+// processes of the same host
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "arrow/buffer.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/io_util.h"
+
+#ifdef _WIN32
+#include "arrow/util/windows_compatibility.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+#endif
+
+namespace arrow {
+namespace io {
+
+namespace internal {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory rings need lock-free atomics");
+
+// The control block at the start of a shared memory ring.  `head` and `tail`
+// count the bytes written and released since the ring was created; the
+// sequence numbers are bumped on every change and serve as futex words (on
+// Windows, a change also signals an event named after `event_name`).
+struct SharedMemoryRingHeader {
+  static constexpr uint64_t kMagic = 0x474e4952574f5241ULL;  // "AROWRING"
+  static constexpr uint32_t kVersion = 1;
+
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  int64_t capacity;
+
+  // Written by the producer
+  alignas(64) std::atomic<uint64_t> head;
+  std::atomic<uint32_t> data_seq;
+  std::atomic<uint32_t> writer_closed;
+  std::atomic<uint32_t> reader_waiting;
+
+  // Written by the consumer
+  alignas(64) std::atomic<uint64_t> tail;
+  std::atomic<uint32_t> space_seq;
+  std::atomic<uint32_t> reader_closed;
+  std::atomic<uint32_t> writer_waiting;
+
+#ifdef _WIN32
+  // The base name of the events of the ring
+  char event_name[256];
+#endif
+};
+
+#ifdef _WIN32
+
+// An owned handle of a file mapping object or an event
+class SharedMemoryHandle {
+ public:
+  explicit SharedMemoryHandle(HANDLE handle = NULLPTR) : handle_(handle) {}
+  SharedMemoryHandle(SharedMemoryHandle&& other) : handle_(other.handle_) {
+    other.handle_ = NULLPTR;
+  }
+  SharedMemoryHandle& operator=(SharedMemoryHandle&& other) {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  SharedMemoryHandle(const SharedMemoryHandle&) = delete;
+  SharedMemoryHandle& operator=(const SharedMemoryHandle&) = delete;
+
+  ~SharedMemoryHandle() {
+    if (handle_ != NULLPTR) CloseHandle(handle_);
+  }
+
+  HANDLE handle() const { return handle_; }
+
+ private:
+  HANDLE handle_;
+};
+
+// The shared memory object backing a ring
+using SharedMemorySegment = SharedMemoryHandle;
+// An auto-reset event signalled when a sequence number changes, since
+// WaitOnAddress() does not work across processes
+using SharedMemoryEvent = SharedMemoryHandle;
+
+#else
+
+using SharedMemorySegment = ::arrow::internal::FileDescriptor;
+// Futexes need no separate object
+struct SharedMemoryEvent {};
+
+#endif
+
+// Wait until `*word` differs from `expected`, or a short timeout elapses
+inline void WaitOnSequence(std::atomic<uint32_t>* word, uint32_t expected,
+                           const SharedMemoryEvent& event) {
+#if defined(_WIN32)
+  ARROW_UNUSED(word);
+  ARROW_UNUSED(expected);
+  WaitForSingleObject(event.handle(), 100);
+#elif defined(__linux__)
+  ARROW_UNUSED(event);
+  struct timespec timeout = {0, 100 * 1000 * 1000};
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &timeout,
+          NULLPTR, 0);
+#else
+  ARROW_UNUSED(event);
+  if (word->load() == expected) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+#endif
+}
+
+// Bump `*word` and wake up the peer if it announced it is waiting on it
+inline void NotifySequence(std::atomic<uint32_t>* word, std::atomic<uint32_t>* waiting,
+                           const SharedMemoryEvent& event) {
+  word->fetch_add(1);
+#if defined(_WIN32)
+  if (waiting->load() != 0) {
+    SetEvent(event.handle());
+  }
+#elif defined(__linux__)
+  ARROW_UNUSED(event);
+  if (waiting->load() != 0) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, NULLPTR,
+            NULLPTR, 0);
+  }
+#else
+  ARROW_UNUSED(waiting);
+  ARROW_UNUSED(event);
+#endif
+}
+
+// Wait until `ready()`, spinning briefly before sleeping on `*word`
+template <typename Predicate>
+void WaitUntil(std::atomic<uint32_t>* word, std::atomic<uint32_t>* waiting,
+               const SharedMemoryEvent& event, Predicate&& ready) {
+  for (int spins = 0; spins < 64; ++spins) {
+    if (ready()) return;
+    std::this_thread::yield();
+  }
+  while (true) {
+    const uint32_t seq = word->load();
+    if (ready()) return;
+    waiting->store(1);
+    if (word->load() == seq && !ready()) WaitOnSequence(word, seq, event);
+    waiting->store(0);
+  }
+}
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: A single-producer, single-consumer ring buffer in a
+/// shared memory segment
+///
+/// On POSIX systems, the segment is a memfd (anonymous, to be passed to the
+/// other process by fork() or over a Unix socket) or a named POSIX shared
+/// memory object.  On Windows, it is a file mapping object, anonymous (its
+/// handle is passed to the other process with DuplicateHandle()) or named.
+/// Its data region is mapped twice in a row, so that any range of up to
+/// `capacity()` bytes starting in the ring is contiguous in memory, even
+/// when it wraps around.
+///
+/// Each process maps the segment into its own SharedMemoryRing, then one
+/// process writes to it through a SharedMemoryOutputStream and the other
+/// reads from it through a SharedMemoryInputStream.
+class SharedMemoryRing {
+ public:
+  static constexpr int64_t kDefaultCapacity = 64 << 20;
+
+  ~SharedMemoryRing() { Unmap(); }
+
+  /// \brief Create a ring of at least `capacity` bytes
+  ///
+  /// \param[in] capacity the size of the data region, rounded up to a page (to
+  /// the allocation granularity on Windows)
+  /// \param[in] name the name of the shared memory object to create: a POSIX
+  /// shared memory object (e.g. "/arrow-ring") or a Windows file mapping
+  /// object (e.g. "Local\\arrow-ring").  If empty, the segment is anonymous,
+  /// which on POSIX systems needs a Linux memfd.
+  static Result<std::shared_ptr<SharedMemoryRing>> Create(
+      int64_t capacity = kDefaultCapacity, const std::string& name = "") {
+    if (capacity <= 0) {
+      return Status::Invalid("Shared memory ring capacity must be positive");
+    }
+    const int64_t page_size = PageSize();
+    capacity = (capacity + page_size - 1) / page_size * page_size;
+    ARROW_ASSIGN_OR_RAISE(auto segment, CreateSegment(name, page_size + capacity));
+    ARROW_ASSIGN_OR_RAISE(auto ring, Map(std::move(segment), name, page_size));
+    auto header = ring->header();
+    header->capacity = capacity;
+    header->head.store(0);
+    header->data_seq.store(0);
+    header->writer_closed.store(0);
+    header->reader_waiting.store(0);
+    header->tail.store(0);
+    header->space_seq.store(0);
+    header->reader_closed.store(0);
+    header->writer_waiting.store(0);
+#ifdef _WIN32
+    RETURN_NOT_OK(ring->CreateEvents(name));
+#endif
+    header->version = internal::SharedMemoryRingHeader::kVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = internal::SharedMemoryRingHeader::kMagic;
+    RETURN_NOT_OK(ring->MapData());
+    return ring;
+  }
+
+  /// \brief Map the named ring created by another process
+  static Result<std::shared_ptr<SharedMemoryRing>> Open(const std::string& name) {
+    ARROW_ASSIGN_OR_RAISE(auto segment, OpenSegment(name));
+    return Open(std::move(segment), name);
+  }
+
+#ifdef _WIN32
+  /// \brief Map the ring of a file mapping handle received from another
+  /// process
+  ///
+  /// The handle is duplicated and can be closed by the caller.
+  static Result<std::shared_ptr<SharedMemoryRing>> FromHandle(HANDLE handle) {
+    HANDLE dup_handle = NULLPTR;
+    if (!DuplicateHandle(GetCurrentProcess(), handle, GetCurrentProcess(), &dup_handle,
+                         0, FALSE, DUPLICATE_SAME_ACCESS)) {
+      return ::arrow::internal::IOErrorFromWinError(GetLastError(),
+                                                    "DuplicateHandle failed");
+    }
+    return Open(internal::SharedMemoryHandle(dup_handle), "");
+  }
+
+  /// \brief No-op: the name of a file mapping object goes away with its last
+  /// handle
+  Status Unlink() { return Status::OK(); }
+
+  /// \brief The handle of the segment, to pass to the other process
+  HANDLE handle() const { return segment_.handle(); }
+#else
+  /// \brief Map the ring of a file descriptor received from another process
+  ///
+  /// The descriptor is duplicated and can be closed by the caller.
+  static Result<std::shared_ptr<SharedMemoryRing>> FromFileDescriptor(int fd) {
+    const int dup_fd = dup(fd);
+    if (dup_fd < 0) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "dup failed");
+    }
+    return Open(::arrow::internal::FileDescriptor(dup_fd), "");
+  }
+
+  /// \brief Remove the name of a named ring; mappings stay valid
+  Status Unlink() {
+    if (name_.empty()) return Status::OK();
+    if (shm_unlink(name_.c_str()) != 0) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "shm_unlink('", name_,
+                                                 "') failed");
+    }
+    return Status::OK();
+  }
+
+  /// \brief The descriptor of the segment, to pass to the other process
+  int file_descriptor() const { return segment_.fd(); }
+#endif
+
+  const std::string& name() const { return name_; }
+  int64_t capacity() const { return header()->capacity; }
+
+  /// \cond FALSE
+  internal::SharedMemoryRingHeader* header() const {
+    return reinterpret_cast<internal::SharedMemoryRingHeader*>(mapping_);
+  }
+  // The data at `position`, contiguous for up to capacity() bytes
+  uint8_t* data(uint64_t position) const {
+    return data_ + position % static_cast<uint64_t>(capacity());
+  }
+  // Signalled when data is written, and when space is released, respectively
+  const internal::SharedMemoryEvent& data_event() const { return data_event_; }
+  const internal::SharedMemoryEvent& space_event() const { return space_event_; }
+  /// \endcond
+
+ private:
+  SharedMemoryRing(internal::SharedMemorySegment segment, std::string name,
+                   int64_t page_size)
+      : segment_(std::move(segment)), name_(std::move(name)), page_size_(page_size) {}
+
+  static Result<std::shared_ptr<SharedMemoryRing>> Open(
+      internal::SharedMemorySegment segment, const std::string& name) {
+    const int64_t page_size = PageSize();
+    ARROW_ASSIGN_OR_RAISE(auto ring, Map(std::move(segment), name, page_size));
+    const auto header = ring->header();
+    if (header->magic != internal::SharedMemoryRingHeader::kMagic) {
+      return Status::Invalid("Not a shared memory ring, or not initialized yet");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->version != internal::SharedMemoryRingHeader::kVersion) {
+      return Status::NotImplemented("Unsupported shared memory ring version ",
+                                    header->version);
+    }
+    if (header->capacity <= 0 || header->capacity % page_size != 0) {
+      return Status::Invalid("Corrupt shared memory ring header");
+    }
+#ifdef _WIN32
+    RETURN_NOT_OK(ring->OpenEvents());
+#else
+    struct stat st;
+    if (fstat(ring->segment_.fd(), &st) != 0) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "fstat failed");
+    }
+    if (st.st_size < page_size + header->capacity) {
+      return Status::Invalid("Corrupt shared memory ring header");
+    }
+#endif
+    // On Windows, mapping the data region fails if the segment is too small
+    RETURN_NOT_OK(ring->MapData());
+    return ring;
+  }
+
+#ifdef _WIN32
+  // Views must start at multiples of the allocation granularity, so the
+  // header takes that much room
+  static int64_t PageSize() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<int64_t>(info.dwAllocationGranularity);
+  }
+
+  static Result<internal::SharedMemorySegment> CreateSegment(const std::string& name,
+                                                             int64_t size) {
+    const auto size_bytes = static_cast<uint64_t>(size);
+    HANDLE handle = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, NULLPTR, PAGE_READWRITE,
+        static_cast<DWORD>(size_bytes >> 32), static_cast<DWORD>(size_bytes),
+        name.empty() ? NULLPTR : name.c_str());
+    const DWORD error = GetLastError();
+    if (handle == NULLPTR) {
+      return ::arrow::internal::IOErrorFromWinError(error, "CreateFileMapping('", name,
+                                                    "') failed");
+    }
+    internal::SharedMemoryHandle segment(handle);
+    if (error == ERROR_ALREADY_EXISTS) {
+      return Status::IOError("Shared memory object '", name, "' already exists");
+    }
+    return segment;
+  }
+
+  static Result<internal::SharedMemorySegment> OpenSegment(const std::string& name) {
+    HANDLE handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (handle == NULLPTR) {
+      return ::arrow::internal::IOErrorFromWinError(GetLastError(), "OpenFileMapping('",
+                                                    name, "') failed");
+    }
+    return internal::SharedMemoryHandle(handle);
+  }
+
+  // Create the events of the ring, named after the ring or, for an anonymous
+  // ring, after the process
+  Status CreateEvents(const std::string& name) {
+    std::string base = name;
+    if (base.empty()) {
+      static std::atomic<uint64_t> counter{0};
+      base = "Local\\arrow-ring-" + std::to_string(GetCurrentProcessId()) + "-" +
+             std::to_string(GetTickCount64()) + "-" + std::to_string(counter++);
+    }
+    auto header = this->header();
+    if (base.size() >= sizeof(header->event_name)) {
+      return Status::Invalid("Shared memory ring name too long: '", name, "'");
+    }
+    std::memcpy(header->event_name, base.c_str(), base.size() + 1);
+    ARROW_ASSIGN_OR_RAISE(data_event_, MakeEvent(base + "-data", /*create=*/true));
+    ARROW_ASSIGN_OR_RAISE(space_event_, MakeEvent(base + "-space", /*create=*/true));
+    return Status::OK();
+  }
+
+  Status OpenEvents() {
+    auto header = this->header();
+    if (std::memchr(header->event_name, 0, sizeof(header->event_name)) == NULLPTR) {
+      return Status::Invalid("Corrupt shared memory ring header");
+    }
+    const std::string base(header->event_name);
+    ARROW_ASSIGN_OR_RAISE(data_event_, MakeEvent(base + "-data", /*create=*/false));
+    ARROW_ASSIGN_OR_RAISE(space_event_, MakeEvent(base + "-space", /*create=*/false));
+    return Status::OK();
+  }
+
+  static Result<internal::SharedMemoryEvent> MakeEvent(const std::string& name,
+                                                       bool create) {
+    HANDLE handle =
+        create ? CreateEventA(NULLPTR, /*bManualReset=*/FALSE, /*bInitialState=*/FALSE,
+                              name.c_str())
+               : OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name.c_str());
+    const DWORD error = GetLastError();
+    if (handle == NULLPTR) {
+      return ::arrow::internal::IOErrorFromWinError(
+          error, create ? "CreateEvent('" : "OpenEvent('", name, "') failed");
+    }
+    internal::SharedMemoryEvent event(handle);
+    if (create && error == ERROR_ALREADY_EXISTS) {
+      return Status::IOError("Event '", name, "' already exists");
+    }
+    return event;
+  }
+
+  // Map the header page only
+  static Result<std::shared_ptr<SharedMemoryRing>> Map(
+      internal::SharedMemorySegment segment, const std::string& name,
+      int64_t page_size) {
+    std::shared_ptr<SharedMemoryRing> ring(
+        new SharedMemoryRing(std::move(segment), name, page_size));
+    ring->mapping_ = MapViewOfFile(ring->segment_.handle(), FILE_MAP_ALL_ACCESS, 0, 0,
+                                   static_cast<SIZE_T>(page_size));
+    if (ring->mapping_ == NULLPTR) {
+      return ::arrow::internal::IOErrorFromWinError(GetLastError(),
+                                                    "MapViewOfFile failed");
+    }
+    return ring;
+  }
+
+  // Remap the header followed by two views of the data region.  Views cannot be
+  // placed in reserved memory, so room is found by reserving and releasing an
+  // address range, then both views are mapped there, retrying if another
+  // thread took the range in between.
+  Status MapData() {
+    const auto capacity = static_cast<SIZE_T>(header()->capacity);
+    const auto page_size = static_cast<SIZE_T>(page_size_);
+    Unmap();
+    for (int attempt = 0; attempt < 16; ++attempt) {
+      auto base = static_cast<uint8_t*>(VirtualAlloc(NULLPTR, page_size + 2 * capacity,
+                                                     MEM_RESERVE, PAGE_NOACCESS));
+      if (base == NULLPTR) {
+        return ::arrow::internal::IOErrorFromWinError(GetLastError(),
+                                                      "VirtualAlloc failed");
+      }
+      VirtualFree(base, 0, MEM_RELEASE);
+      void* first = MapViewOfFileEx(segment_.handle(), FILE_MAP_ALL_ACCESS, 0, 0,
+                                    page_size + capacity, base);
+      if (first == NULLPTR) {
+        const DWORD error = GetLastError();
+        if (error == ERROR_INVALID_ADDRESS) continue;
+        return ::arrow::internal::IOErrorFromWinError(error, "MapViewOfFileEx failed");
+      }
+      void* second = MapViewOfFileEx(segment_.handle(), FILE_MAP_ALL_ACCESS, 0,
+                                     static_cast<DWORD>(page_size), capacity,
+                                     base + page_size + capacity);
+      if (second == NULLPTR) {
+        const DWORD error = GetLastError();
+        UnmapViewOfFile(first);
+        if (error == ERROR_INVALID_ADDRESS) continue;
+        return ::arrow::internal::IOErrorFromWinError(error, "MapViewOfFileEx failed");
+      }
+      mapping_ = first;
+      data_view_ = second;
+      data_ = base + page_size;
+      return Status::OK();
+    }
+    return Status::IOError("Could not find room to map the shared memory ring");
+  }
+
+  void Unmap() {
+    if (data_view_ != NULLPTR) UnmapViewOfFile(data_view_);
+    if (mapping_ != NULLPTR) UnmapViewOfFile(mapping_);
+    data_view_ = mapping_ = NULLPTR;
+  }
+
+  internal::SharedMemorySegment segment_;
+  std::string name_;
+  int64_t page_size_;
+  // The header followed by the data region, and the second view of the latter
+  void* mapping_ = NULLPTR;
+  void* data_view_ = NULLPTR;
+  uint8_t* data_ = NULLPTR;
+#else
+  static int64_t PageSize() { return sysconf(_SC_PAGESIZE); }
+
+  static Result<internal::SharedMemorySegment> CreateSegment(const std::string& name,
+                                                             int64_t size) {
+    int fd;
+    if (name.empty()) {
+#ifdef __linux__
+      fd = static_cast<int>(syscall(SYS_memfd_create, "arrow-ring", 0));
+      if (fd < 0) {
+        return ::arrow::internal::IOErrorFromErrno(errno, "memfd_create failed");
+      }
+#else
+      return Status::NotImplemented("Anonymous shared memory rings need Linux memfd");
+#endif
+    } else {
+      fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      if (fd < 0) {
+        return ::arrow::internal::IOErrorFromErrno(errno, "shm_open('", name,
+                                                   "') failed");
+      }
+    }
+    ::arrow::internal::FileDescriptor segment(fd);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "ftruncate failed");
+    }
+    return segment;
+  }
+
+  static Result<internal::SharedMemorySegment> OpenSegment(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "shm_open('", name, "') failed");
+    }
+    return ::arrow::internal::FileDescriptor(fd);
+  }
+
+  // Map the header page only
+  static Result<std::shared_ptr<SharedMemoryRing>> Map(
+      internal::SharedMemorySegment segment, const std::string& name,
+      int64_t page_size) {
+    std::shared_ptr<SharedMemoryRing> ring(
+        new SharedMemoryRing(std::move(segment), name, page_size));
+    ring->mapping_size_ = static_cast<size_t>(page_size);
+    ring->mapping_ = mmap(NULLPTR, ring->mapping_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, ring->segment_.fd(), 0);
+    if (ring->mapping_ == MAP_FAILED) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "mmap failed");
+    }
+    return ring;
+  }
+
+  // Remap the header followed by two views of the data region
+  Status MapData() {
+    const auto capacity = static_cast<size_t>(header()->capacity);
+    const auto page_size = static_cast<size_t>(page_size_);
+    Unmap();
+    mapping_size_ = page_size + 2 * capacity;
+    mapping_ = mmap(NULLPTR, mapping_size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+    if (mapping_ == MAP_FAILED) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "mmap failed");
+    }
+    auto base = static_cast<uint8_t*>(mapping_);
+    if (mmap(base, page_size + capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             segment_.fd(), 0) == MAP_FAILED ||
+        mmap(base + page_size + capacity, capacity, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, segment_.fd(),
+             static_cast<off_t>(page_size)) == MAP_FAILED) {
+      return ::arrow::internal::IOErrorFromErrno(errno, "mmap failed");
+    }
+    data_ = base + page_size;
+    return Status::OK();
+  }
+
+  void Unmap() {
+    if (mapping_ != MAP_FAILED) munmap(mapping_, mapping_size_);
+    mapping_ = MAP_FAILED;
+  }
+
+  internal::SharedMemorySegment segment_;
+  std::string name_;
+  int64_t page_size_;
+  void* mapping_ = MAP_FAILED;
+  size_t mapping_size_ = 0;
+  uint8_t* data_ = NULLPTR;
+#endif
+  internal::SharedMemoryEvent data_event_;
+  internal::SharedMemoryEvent space_event_;
+};
+
+/// \brief EXPERIMENTAL: The producer end of a SharedMemoryRing
+///
+/// Writes are copied into the ring and published to the consumer at once,
+/// waiting while the ring is full.  Writing fails once the consumer closed
+/// its end.  This class is not thread-safe.
+class SharedMemoryOutputStream : public OutputStream {
+ public:
+  static Result<std::shared_ptr<SharedMemoryOutputStream>> Make(
+      std::shared_ptr<SharedMemoryRing> ring) {
+    return std::shared_ptr<SharedMemoryOutputStream>(
+        new SharedMemoryOutputStream(std::move(ring)));
+  }
+
+  ~SharedMemoryOutputStream() override { ARROW_UNUSED(Close()); }
+
+  Status Close() override {
+    if (!closed_) {
+      closed_ = true;
+      auto header = ring_->header();
+      header->writer_closed.store(1);
+      internal::NotifySequence(&header->data_seq, &header->reader_waiting,
+                               ring_->data_event());
+    }
+    return Status::OK();
+  }
+
+  bool closed() const override { return closed_; }
+
+  Result<int64_t> Tell() const override {
+    RETURN_NOT_OK(CheckClosed());
+    return static_cast<int64_t>(head_);
+  }
+
+  Status Write(const void* data, int64_t nbytes) override {
+    RETURN_NOT_OK(CheckClosed());
+    auto header = ring_->header();
+    const auto capacity = static_cast<uint64_t>(ring_->capacity());
+    auto bytes = static_cast<const uint8_t*>(data);
+    while (nbytes > 0) {
+      uint64_t tail = header->tail.load(std::memory_order_acquire);
+      if (head_ - tail == capacity) {
+        internal::WaitUntil(&header->space_seq, &header->writer_waiting,
+                            ring_->space_event(), [&] {
+          tail = header->tail.load(std::memory_order_acquire);
+          return head_ - tail < capacity || header->reader_closed.load() != 0;
+        });
+      }
+      if (header->reader_closed.load() != 0) {
+        return Status::IOError("Shared memory ring closed by the reader");
+      }
+      const auto chunk =
+          std::min(static_cast<uint64_t>(nbytes), capacity - (head_ - tail));
+      std::memcpy(ring_->data(head_), bytes, chunk);
+      head_ += chunk;
+      header->head.store(head_, std::memory_order_release);
+      internal::NotifySequence(&header->data_seq, &header->reader_waiting,
+                               ring_->data_event());
+      bytes += chunk;
+      nbytes -= static_cast<int64_t>(chunk);
+    }
+    return Status::OK();
+  }
+
+  using OutputStream::Write;
+
+ private:
+  explicit SharedMemoryOutputStream(std::shared_ptr<SharedMemoryRing> ring)
+      : ring_(std::move(ring)), head_(ring_->header()->head.load()) {}
+
+  Status CheckClosed() const {
+    if (closed_) return Status::Invalid("Operation on closed stream");
+    return Status::OK();
+  }
+
+  std::shared_ptr<SharedMemoryRing> ring_;
+  uint64_t head_;
+  bool closed_ = false;
+};
+
+/// \brief EXPERIMENTAL: The consumer end of a SharedMemoryRing
+///
+/// Read(nbytes) returns Buffers pointing into the shared segment.  Their
+/// bytes (and the bytes read before them) are released back to the producer
+/// once the Buffer and all its slices are destroyed, so an IPC reader over
+/// this stream produces record batches without copying their bodies.  Reads
+/// larger than the ring are copied into `pool`, in chunks.
+///
+/// Buffers pin the ring: the consumer must not hold more than `capacity()`
+/// bytes of read data at once while it waits for more, or both ends wait for
+/// each other.  Size the ring for the batches kept alive at a time plus the
+/// largest message.  Read methods are not thread-safe; Buffers can be
+/// released from any thread.
+class SharedMemoryInputStream : public InputStream {
+ public:
+  static Result<std::shared_ptr<SharedMemoryInputStream>> Make(
+      std::shared_ptr<SharedMemoryRing> ring, MemoryPool* pool = default_memory_pool()) {
+    return std::shared_ptr<SharedMemoryInputStream>(
+        new SharedMemoryInputStream(std::move(ring), pool));
+  }
+
+  ~SharedMemoryInputStream() override { ARROW_UNUSED(Close()); }
+
+  Status Close() override {
+    if (!closed_) {
+      closed_ = true;
+      auto header = pins_->ring->header();
+      header->reader_closed.store(1);
+      internal::NotifySequence(&header->space_seq, &header->writer_waiting,
+                               pins_->ring->space_event());
+    }
+    return Status::OK();
+  }
+
+  bool closed() const override { return closed_; }
+
+  Result<int64_t> Tell() const override {
+    RETURN_NOT_OK(CheckClosed());
+    return static_cast<int64_t>(position_);
+  }
+
+  bool supports_zero_copy() const override { return true; }
+
+  Result<int64_t> Read(int64_t nbytes, void* out) override {
+    RETURN_NOT_OK(CheckClosed());
+    auto bytes = static_cast<uint8_t*>(out);
+    int64_t total = 0;
+    while (total < nbytes) {
+      // Waiting for more than a byte could wait for bytes pinned by Buffers
+      const int64_t available = WaitForData(1);
+      if (available == 0) break;
+      const int64_t chunk = std::min(nbytes - total, available);
+      std::memcpy(bytes + total, pins_->ring->data(position_), chunk);
+      position_ += chunk;
+      pins_->Advance(position_);
+      total += chunk;
+    }
+    return total;
+  }
+
+  Result<std::shared_ptr<Buffer>> Read(int64_t nbytes) override {
+    RETURN_NOT_OK(CheckClosed());
+    if (nbytes > pins_->ring->capacity()) {
+      ARROW_ASSIGN_OR_RAISE(auto buffer, AllocateResizableBuffer(nbytes, pool_));
+      ARROW_ASSIGN_OR_RAISE(auto bytes_read, Read(nbytes, buffer->mutable_data()));
+      if (bytes_read < nbytes) {
+        RETURN_NOT_OK(buffer->Resize(bytes_read, /*shrink_to_fit=*/false));
+      }
+      return std::shared_ptr<Buffer>(std::move(buffer));
+    }
+    const int64_t size = std::min(nbytes, WaitForData(nbytes));
+    if (size == 0) return AllocateBuffer(0, pool_);
+    auto buffer = std::make_shared<PinnedBuffer>(pins_, position_, size);
+    position_ += size;
+    pins_->Advance(position_);
+    return buffer;
+  }
+
+  Result<std::string_view> Peek(int64_t nbytes) override {
+    RETURN_NOT_OK(CheckClosed());
+    nbytes = std::min(nbytes, pins_->ring->capacity());
+    const int64_t size = std::min(nbytes, WaitForData(nbytes));
+    return std::string_view(reinterpret_cast<const char*>(pins_->ring->data(position_)),
+                            static_cast<size_t>(size));
+  }
+
+ private:
+  // The ranges of the ring still referenced by Buffers
+  struct Pins {
+    explicit Pins(std::shared_ptr<SharedMemoryRing> shared_ring)
+        : ring(std::move(shared_ring)), read(ring->header()->tail.load()) {}
+
+    void Pin(uint64_t start) {
+      std::lock_guard<std::mutex> lock(mutex);
+      starts.insert(start);
+    }
+
+    void Unpin(uint64_t start) {
+      std::lock_guard<std::mutex> lock(mutex);
+      starts.erase(starts.find(start));
+      Publish();
+    }
+
+    // Note that everything before `position` was read
+    void Advance(uint64_t position) {
+      std::lock_guard<std::mutex> lock(mutex);
+      read = position;
+      Publish();
+    }
+
+    // Release everything before the oldest pinned byte
+    void Publish() {
+      const uint64_t tail = starts.empty() ? read : *starts.begin();
+      auto header = ring->header();
+      if (tail != header->tail.load(std::memory_order_relaxed)) {
+        header->tail.store(tail, std::memory_order_release);
+        internal::NotifySequence(&header->space_seq, &header->writer_waiting,
+                                 ring->space_event());
+      }
+    }
+
+    std::shared_ptr<SharedMemoryRing> ring;
+    std::mutex mutex;
+    std::multiset<uint64_t> starts;
+    uint64_t read;
+  };
+
+  class PinnedBuffer : public Buffer {
+   public:
+    PinnedBuffer(std::shared_ptr<Pins> pins, uint64_t start, int64_t size)
+        : Buffer(pins->ring->data(start), size), pins_(std::move(pins)), start_(start) {
+      pins_->Pin(start_);
+    }
+
+    ~PinnedBuffer() override { pins_->Unpin(start_); }
+
+   private:
+    std::shared_ptr<Pins> pins_;
+    uint64_t start_;
+  };
+
+  SharedMemoryInputStream(std::shared_ptr<SharedMemoryRing> ring, MemoryPool* pool)
+      : pins_(std::make_shared<Pins>(std::move(ring))), pool_(pool) {
+    position_ = pins_->read;
+  }
+
+  Status CheckClosed() const {
+    if (closed_) return Status::Invalid("Operation on closed stream");
+    return Status::OK();
+  }
+
+  // Wait until `nbytes` (at most the capacity) can be read or the producer
+  // closed the ring, and return the number of bytes available
+  int64_t WaitForData(int64_t nbytes) {
+    auto header = pins_->ring->header();
+    auto available = [&] {
+      return static_cast<int64_t>(header->head.load(std::memory_order_acquire) -
+                                  position_);
+    };
+    if (available() < nbytes) {
+      internal::WaitUntil(&header->data_seq, &header->reader_waiting,
+                          pins_->ring->data_event(), [&] {
+        return available() >= nbytes || header->writer_closed.load() != 0;
+      });
+    }
+    return available();
+  }
+
+  std::shared_ptr<Pins> pins_;
+  MemoryPool* pool_;
+  uint64_t position_;
+  bool closed_ = false;
+};
+
+}  // namespace io
+}  // namespace arrow
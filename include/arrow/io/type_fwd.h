@@ -72,6 +72,12 @@ class CompressedInputStream;
 class CompressedOutputStream;
 class BufferedInputStream;
 class BufferedOutputStream;
+class PrefetchBudget;
+class PrefetchingInputStream;
+class AdaptiveReadaheadInputStream;
+class SharedMemoryRing;
+class SharedMemoryInputStream;
+class SharedMemoryOutputStream;
 
 }  // namespace io
 }  // namespace arrow
@@ -0,0 +1,294 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Batched implementation of RandomAccessFile::ReadManyAsync
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "arrow/buffer.h"
+#include "arrow/io/file.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/future.h"
+#include "arrow/util/io_util.h"
+#include "arrow/util/thread_pool.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+
+namespace arrow {
+namespace io {
+
+struct VectoredReadOptions {
+  /// \brief The maximum number of IO tasks a ReadManyAsync() call is split
+  /// into, or 0 for the capacity of the IOContext's executor
+  int max_tasks = 0;
+  /// \brief The minimum number of bytes read by a task; smaller requests are
+  /// not split further
+  int64_t min_task_size = 4 << 20;
+};
+
+namespace internal {
+
+#ifndef _WIN32
+
+/// \brief Read ranges that follow each other in the file with preadv()
+///
+/// Buffers of ranges past the end of the file are truncated.  Empty ranges get
+/// empty buffers.
+inline Result<std::vector<std::shared_ptr<Buffer>>> ReadAdjacentRanges(
+    int fd, const std::vector<ReadRange>& ranges, MemoryPool* pool) {
+  std::vector<std::shared_ptr<ResizableBuffer>> buffers;
+  buffers.reserve(ranges.size());
+  for (const auto& range : ranges) {
+    ARROW_ASSIGN_OR_RAISE(auto buffer, AllocateResizableBuffer(range.length, pool));
+    buffers.push_back(std::move(buffer));
+  }
+  std::vector<int64_t> filled(ranges.size(), 0);
+  std::vector<struct iovec> iovs;
+  size_t first = 0;
+  while (true) {
+    // Skip the complete ranges, including empty ones, which would otherwise
+    // never be passed by the byte count of a read
+    while (first < ranges.size() && filled[first] == ranges[first].length) ++first;
+    if (first == ranges.size()) break;
+    iovs.clear();
+    for (size_t i = first;
+         i < ranges.size() && iovs.size() < static_cast<size_t>(IOV_MAX); ++i) {
+      if (filled[i] == ranges[i].length) continue;
+      iovs.push_back({buffers[i]->mutable_data() + filled[i],
+                      static_cast<size_t>(ranges[i].length - filled[i])});
+    }
+    const auto ret = preadv(fd, iovs.data(), static_cast<int>(iovs.size()),
+                            static_cast<off_t>(ranges[first].offset + filled[first]));
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return ::arrow::internal::IOErrorFromErrno(errno, "preadv failed");
+    }
+    if (ret == 0) break;  // end of file
+    for (int64_t remaining = ret; remaining > 0;) {
+      while (filled[first] == ranges[first].length) ++first;
+      const int64_t n = std::min(remaining, ranges[first].length - filled[first]);
+      filled[first] += n;
+      remaining -= n;
+    }
+  }
+  std::vector<std::shared_ptr<Buffer>> out;
+  out.reserve(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (filled[i] < ranges[i].length) {
+      RETURN_NOT_OK(buffers[i]->Resize(filled[i]));
+    }
+    out.push_back(std::move(buffers[i]));
+  }
+  return out;
+}
+
+#endif  // _WIN32
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: A RandomAccessFile with a batched ReadManyAsync()
+///
+/// The default ReadManyAsync() issues one ReadAsync(), hence one IO pool task,
+/// per range.  This wrapper splits the ranges of a call into at most
+/// `max_tasks` tasks of neighbouring ranges instead, so that reading a plan of
+/// thousands of small ranges costs a handful of tasks.  Ranges that follow each
+/// other in the file are read with a single preadv() system call, except on
+/// Windows.
+///
+/// Batching only applies when the wrapped file is a local ReadableFile.  For
+/// other files, such as those of remote filesystems, whose reads are best
+/// issued concurrently, ReadManyAsync() and all other methods are forwarded to
+/// the wrapped file.
+class VectoredRandomAccessFile : public RandomAccessFile {
+ public:
+  static std::shared_ptr<VectoredRandomAccessFile> Make(
+      std::shared_ptr<RandomAccessFile> file, const VectoredReadOptions& options = {}) {
+    return std::shared_ptr<VectoredRandomAccessFile>(
+        new VectoredRandomAccessFile(std::move(file), options));
+  }
+
+  const std::shared_ptr<RandomAccessFile>& file() const { return file_; }
+
+  Status Close() override { return file_->Close(); }
+  Future<> CloseAsync() override { return file_->CloseAsync(); }
+  Status Abort() override { return file_->Abort(); }
+  bool closed() const override { return file_->closed(); }
+  Result<int64_t> Tell() const override { return file_->Tell(); }
+  Status Seek(int64_t position) override { return file_->Seek(position); }
+  Result<int64_t> GetSize() override { return file_->GetSize(); }
+
+  Result<int64_t> Read(int64_t nbytes, void* out) override {
+    return file_->Read(nbytes, out);
+  }
+  Result<std::shared_ptr<Buffer>> Read(int64_t nbytes) override {
+    return file_->Read(nbytes);
+  }
+  Result<std::string_view> Peek(int64_t nbytes) override { return file_->Peek(nbytes); }
+  bool supports_zero_copy() const override { return file_->supports_zero_copy(); }
+  const IOContext& io_context() const override { return file_->io_context(); }
+
+  Result<std::shared_ptr<const KeyValueMetadata>> ReadMetadata() override {
+    return file_->ReadMetadata();
+  }
+  using RandomAccessFile::ReadMetadataAsync;
+  Future<std::shared_ptr<const KeyValueMetadata>> ReadMetadataAsync(
+      const IOContext& io_context) override {
+    return file_->ReadMetadataAsync(io_context);
+  }
+
+  Result<int64_t> ReadAt(int64_t position, int64_t nbytes, void* out) override {
+    return file_->ReadAt(position, nbytes, out);
+  }
+  Result<std::shared_ptr<Buffer>> ReadAt(int64_t position, int64_t nbytes) override {
+    return file_->ReadAt(position, nbytes);
+  }
+
+  using RandomAccessFile::ReadAsync;
+  Future<std::shared_ptr<Buffer>> ReadAsync(const IOContext& io_context, int64_t position,
+                                            int64_t nbytes) override {
+    return file_->ReadAsync(io_context, position, nbytes);
+  }
+
+  Status WillNeed(const std::vector<ReadRange>& ranges) override {
+    return file_->WillNeed(ranges);
+  }
+
+  using RandomAccessFile::ReadManyAsync;
+  std::vector<Future<std::shared_ptr<Buffer>>> ReadManyAsync(
+      const IOContext& io_context, const std::vector<ReadRange>& ranges) override {
+    using BufferFuture = Future<std::shared_ptr<Buffer>>;
+    if (local_file_ == NULLPTR || ranges.size() <= 1) {
+      return file_->ReadManyAsync(io_context, ranges);
+    }
+
+    // Split the ranges, in file order, into tasks of similar sizes
+    std::vector<size_t> order(ranges.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return ranges[a].offset < ranges[b].offset;
+    });
+    int64_t total_size = 0;
+    for (const auto& range : ranges) total_size += range.length;
+    const int max_tasks = options_.max_tasks > 0
+                              ? options_.max_tasks
+                              : std::max(1, io_context.executor()->GetCapacity());
+    const int64_t task_size =
+        std::max(options_.min_task_size, (total_size + max_tasks - 1) / max_tasks);
+
+    std::vector<BufferFuture> futures(ranges.size());
+    std::vector<size_t> task_indices;
+    int64_t task_bytes = 0;
+    auto submit_task = [&]() {
+      std::vector<ReadRange> task_ranges;
+      task_ranges.reserve(task_indices.size());
+      for (size_t index : task_indices) task_ranges.push_back(ranges[index]);
+      auto task_future = DeferNotOk(io_context.executor()->Submit(
+          io_context.stop_token(),
+          [file = local_file_, pool = io_context.pool(),
+           task_ranges = std::move(task_ranges)] {
+            return ReadTask(file, task_ranges, pool);
+          }));
+      for (size_t i = 0; i < task_indices.size(); ++i) {
+        futures[task_indices[i]] = task_future.Then(
+            [i](const std::vector<std::shared_ptr<Buffer>>& buffers) {
+              return buffers[i];
+            });
+      }
+      task_indices.clear();
+      task_bytes = 0;
+    };
+    for (size_t index : order) {
+      task_indices.push_back(index);
+      task_bytes += ranges[index].length;
+      if (task_bytes >= task_size) submit_task();
+    }
+    if (!task_indices.empty()) submit_task();
+    return futures;
+  }
+
+ private:
+  VectoredRandomAccessFile(std::shared_ptr<RandomAccessFile> file,
+                           const VectoredReadOptions& options)
+      : file_(std::move(file)),
+        local_file_(std::dynamic_pointer_cast<ReadableFile>(file_)),
+        options_(options) {}
+
+  // Read `ranges`, sorted by offset, from `file`
+  static Result<std::vector<std::shared_ptr<Buffer>>> ReadTask(
+      const std::shared_ptr<ReadableFile>& file, const std::vector<ReadRange>& ranges,
+      MemoryPool* pool) {
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    buffers.reserve(ranges.size());
+#ifndef _WIN32
+    if (file->closed()) {
+      return Status::Invalid("Operation on closed file");
+    }
+    size_t run_start = 0;
+    while (run_start < ranges.size()) {
+      size_t run_end = run_start + 1;
+      while (run_end < ranges.size() &&
+             ranges[run_end].offset ==
+                 ranges[run_end - 1].offset + ranges[run_end - 1].length) {
+        ++run_end;
+      }
+      if (run_end - run_start == 1) {
+        ARROW_ASSIGN_OR_RAISE(auto buffer, file->ReadAt(ranges[run_start].offset,
+                                                        ranges[run_start].length));
+        buffers.push_back(std::move(buffer));
+      } else {
+        std::vector<ReadRange> run(ranges.begin() + run_start,
+                                   ranges.begin() + run_end);
+        ARROW_ASSIGN_OR_RAISE(
+            auto run_buffers,
+            internal::ReadAdjacentRanges(file->file_descriptor(), run, pool));
+        for (auto& buffer : run_buffers) buffers.push_back(std::move(buffer));
+      }
+      run_start = run_end;
+    }
+#else
+    ARROW_UNUSED(pool);
+    for (const auto& range : ranges) {
+      ARROW_ASSIGN_OR_RAISE(auto buffer, file->ReadAt(range.offset, range.length));
+      buffers.push_back(std::move(buffer));
+    }
+#endif
+    return buffers;
+  }
+
+  std::shared_ptr<RandomAccessFile> file_;
+  // file_ if it is a ReadableFile, whose reads are batched
+  std::shared_ptr<ReadableFile> local_file_;
+  VectoredReadOptions options_;
+};
+
+}  // namespace io
+}  // namespace arrow
@@ -0,0 +1,279 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Per-record batch column statistics in the footer of IPC files
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "arrow/array.h"
+#include "arrow/builder.h"
+#include "arrow/compute/api_aggregate.h"
+#include "arrow/compute/exec.h"
+#include "arrow/datum.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/io/memory.h"
+#include "arrow/ipc/options.h"
+#include "arrow/ipc/reader.h"
+#include "arrow/ipc/writer.h"
+#include "arrow/record_batch.h"
+#include "arrow/result.h"
+#include "arrow/scalar.h"
+#include "arrow/status.h"
+#include "arrow/type.h"
+#include "arrow/type_traits.h"
+#include "arrow/util/base64.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/key_value_metadata.h"
+
+namespace arrow {
+namespace ipc {
+
+/// \brief Footer metadata key under which the statistics of the record
+/// batches of an IPC file are stored, as a base64-encoded IPC stream
+static constexpr char kBatchStatisticsMetadataKey[] = "ipc.batch_statistics";
+
+/// \brief Field metadata key giving the index, in the file schema, of the
+/// column a statistics field describes
+static constexpr char kBatchStatisticsColumnIndexKey[] = "ipc.batch_statistics.column";
+
+namespace internal {
+
+// Whether min/max statistics are collected for columns of type `type`
+inline bool HasBatchStatistics(const DataType& type) {
+  const auto id = type.id();
+  return id == Type::BOOL || is_integer(id) || id == Type::FLOAT ||
+         id == Type::DOUBLE || is_base_binary_like(id) || is_fixed_size_binary(id) ||
+         is_temporal(id);
+}
+
+// The minimum and maximum of `array`, null if unknown
+inline Result<std::pair<std::shared_ptr<Scalar>, std::shared_ptr<Scalar>>> MinMaxOf(
+    const std::shared_ptr<Array>& array) {
+  auto unknown = std::make_pair(MakeNullScalar(array->type()),
+                                MakeNullScalar(array->type()));
+  if (is_floating(array->type_id())) {
+    // Comparisons with NaN are always false, so bounds ignoring NaNs would let
+    // e.g. "not (x < 3)" prune batches holding NaNs
+    ARROW_ASSIGN_OR_RAISE(auto is_nan, compute::CallFunction("is_nan", {array}));
+    ARROW_ASSIGN_OR_RAISE(auto any_nan, compute::Any(is_nan));
+    if (any_nan.scalar()->is_valid &&
+        ::arrow::internal::checked_cast<const BooleanScalar&>(*any_nan.scalar()).value) {
+      return unknown;
+    }
+  }
+  auto maybe_min_max = compute::MinMax(array);
+  if (maybe_min_max.status().IsNotImplemented()) return unknown;
+  ARROW_ASSIGN_OR_RAISE(auto min_max, std::move(maybe_min_max));
+  const auto& values =
+      ::arrow::internal::checked_cast<const StructScalar&>(*min_max.scalar()).value;
+  return std::make_pair(values[0], values[1]);
+}
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: A RecordBatchWriter of IPC files recording column
+/// statistics of each record batch in the footer
+///
+/// For each record batch, the writer records the number of rows and, for
+/// each top-level column of a primitive, temporal or binary-like type, its
+/// null count, minimum and maximum.  Minimum and maximum are null when
+/// unknown, e.g. for floating point columns holding NaNs.
+///
+/// The statistics are themselves a record batch, with a `num_rows` column
+/// followed by one struct<min, max, null_count> column per described column,
+/// tagged with its index in the file schema.  It is serialized as an IPC
+/// stream and stored in the custom metadata of the file footer, under
+/// kBatchStatisticsMetadataKey, where ReadBatchStatistics() finds it.
+/// Readers unaware of it read the file as usual.
+///
+/// Record batches are written to the sink as they come, as with
+/// ipc::MakeFileWriter(); only their statistics are kept until Close().  The
+/// IPC file writer holds on to the footer metadata it was created with and
+/// only serializes it when closed, so the statistics are appended to that
+/// metadata right before closing it.
+class StatisticsFileWriter : public RecordBatchWriter {
+ public:
+  /// \brief Create a writer, as ipc::MakeFileWriter()
+  ///
+  /// \param[in] metadata custom metadata written to the file's footer, along
+  /// with the statistics
+  static Result<std::shared_ptr<StatisticsFileWriter>> Make(
+      std::shared_ptr<io::OutputStream> sink, const std::shared_ptr<Schema>& schema,
+      const IpcWriteOptions& options = IpcWriteOptions::Defaults(),
+      const std::shared_ptr<const KeyValueMetadata>& metadata = NULLPTR) {
+    auto footer_metadata = metadata != NULLPTR ? metadata->Copy()
+                                               : std::make_shared<KeyValueMetadata>();
+    ARROW_ASSIGN_OR_RAISE(
+        auto writer, MakeFileWriter(std::move(sink), schema, options, footer_metadata));
+    return std::shared_ptr<StatisticsFileWriter>(new StatisticsFileWriter(
+        std::move(writer), schema, options, std::move(footer_metadata)));
+  }
+
+  Status WriteRecordBatch(const RecordBatch& batch) override {
+    return WriteRecordBatch(batch, NULLPTR);
+  }
+
+  Status WriteRecordBatch(
+      const RecordBatch& batch,
+      const std::shared_ptr<const KeyValueMetadata>& custom_metadata) override {
+    if (closed_) {
+      return Status::Invalid("Operation on closed writer");
+    }
+    // The IPC writer checks the schema, so only record statistics of batches
+    // it accepted
+    RETURN_NOT_OK(writer_->WriteRecordBatch(batch, custom_metadata));
+    return AddStatistics(batch);
+  }
+
+  Status Close() override {
+    if (closed_) return Status::OK();
+    closed_ = true;
+    ARROW_ASSIGN_OR_RAISE(auto statistics, FinishStatistics());
+    footer_metadata_->Append(kBatchStatisticsMetadataKey, std::move(statistics));
+    return writer_->Close();
+  }
+
+  WriteStats stats() const override { return writer_->stats(); }
+
+ private:
+  StatisticsFileWriter(std::shared_ptr<RecordBatchWriter> writer,
+                       const std::shared_ptr<Schema>& schema,
+                       const IpcWriteOptions& options,
+                       std::shared_ptr<KeyValueMetadata> footer_metadata)
+      : writer_(std::move(writer)),
+        footer_metadata_(std::move(footer_metadata)),
+        pool_(options.memory_pool),
+        num_rows_(options.memory_pool) {
+    for (int i = 0; i < schema->num_fields(); ++i) {
+      const auto& field = schema->field(i);
+      if (!internal::HasBatchStatistics(*field->type())) continue;
+      auto column_metadata = key_value_metadata({kBatchStatisticsColumnIndexKey},
+                                                {std::to_string(i)});
+      ColumnStatistics column;
+      column.index = i;
+      column.field = field->WithMetadata(std::move(column_metadata));
+      columns_.push_back(std::move(column));
+    }
+  }
+
+  struct ColumnStatistics {
+    int index;
+    std::shared_ptr<Field> field;
+    ScalarVector mins;
+    ScalarVector maxes;
+    std::vector<int64_t> null_counts;
+  };
+
+  Status AddStatistics(const RecordBatch& batch) {
+    RETURN_NOT_OK(num_rows_.Append(batch.num_rows()));
+    for (auto& column : columns_) {
+      const auto& array = batch.column(column.index);
+      ARROW_ASSIGN_OR_RAISE(auto min_max, internal::MinMaxOf(array));
+      column.mins.push_back(std::move(min_max.first));
+      column.maxes.push_back(std::move(min_max.second));
+      column.null_counts.push_back(array->null_count());
+    }
+    return Status::OK();
+  }
+
+  Result<std::shared_ptr<Array>> MakeValues(const std::shared_ptr<DataType>& type,
+                                            const ScalarVector& scalars) const {
+    ARROW_ASSIGN_OR_RAISE(auto builder, MakeBuilder(type, pool_));
+    for (const auto& scalar : scalars) {
+      RETURN_NOT_OK(builder->AppendScalar(*scalar));
+    }
+    return builder->Finish();
+  }
+
+  // Serialize the statistics collected so far
+  Result<std::string> FinishStatistics() {
+    FieldVector fields = {field("num_rows", int64(), /*nullable=*/false)};
+    ArrayVector arrays(1);
+    RETURN_NOT_OK(num_rows_.Finish(&arrays[0]));
+    for (const auto& column : columns_) {
+      const auto& type = column.field->type();
+      ARROW_ASSIGN_OR_RAISE(auto mins, MakeValues(type, column.mins));
+      ARROW_ASSIGN_OR_RAISE(auto maxes, MakeValues(type, column.maxes));
+      Int64Builder null_counts(pool_);
+      RETURN_NOT_OK(null_counts.AppendValues(column.null_counts));
+      ARROW_ASSIGN_OR_RAISE(auto null_count_values, null_counts.Finish());
+      ARROW_ASSIGN_OR_RAISE(
+          auto statistics,
+          StructArray::Make({std::move(mins), std::move(maxes),
+                             std::move(null_count_values)},
+                            {"min", "max", "null_count"}));
+      fields.push_back(::arrow::field(column.field->name(), statistics->type(),
+                                      /*nullable=*/false, column.field->metadata()));
+      arrays.push_back(std::move(statistics));
+    }
+    const int64_t num_batches = arrays[0]->length();
+    auto batch =
+        RecordBatch::Make(::arrow::schema(std::move(fields)), num_batches, arrays);
+
+    ARROW_ASSIGN_OR_RAISE(auto sink, io::BufferOutputStream::Create(1024, pool_));
+    auto options = IpcWriteOptions::Defaults();
+    options.memory_pool = pool_;
+    ARROW_ASSIGN_OR_RAISE(auto writer, MakeStreamWriter(sink, batch->schema(), options));
+    RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+    RETURN_NOT_OK(writer->Close());
+    ARROW_ASSIGN_OR_RAISE(auto buffer, sink->Finish());
+    return ::arrow::util::base64_encode(std::string_view(*buffer));
+  }
+
+  std::shared_ptr<RecordBatchWriter> writer_;
+  // Shared with writer_, which writes it to the footer on Close()
+  std::shared_ptr<KeyValueMetadata> footer_metadata_;
+  MemoryPool* pool_;
+  Int64Builder num_rows_;
+  std::vector<ColumnStatistics> columns_;
+  bool closed_ = false;
+};
+
+/// \brief EXPERIMENTAL: Read the record batch statistics written by a
+/// StatisticsFileWriter
+///
+/// \param[in] footer_metadata the footer metadata of the file, see
+/// RecordBatchFileReader::metadata()
+/// \return the statistics, one row per record batch of the file, or null if
+/// the file has none
+inline Result<std::shared_ptr<RecordBatch>> ReadBatchStatistics(
+    const std::shared_ptr<const KeyValueMetadata>& footer_metadata) {
+  if (footer_metadata == NULLPTR) return NULLPTR;
+  const int index = footer_metadata->FindKey(kBatchStatisticsMetadataKey);
+  if (index < 0) return NULLPTR;
+  auto buffer =
+      Buffer::FromString(::arrow::util::base64_decode(footer_metadata->value(index)));
+  auto input = std::make_shared<io::BufferReader>(std::move(buffer));
+  ARROW_ASSIGN_OR_RAISE(auto reader, RecordBatchStreamReader::Open(input));
+  std::shared_ptr<RecordBatch> statistics;
+  RETURN_NOT_OK(reader->ReadNext(&statistics));
+  if (statistics == NULLPTR || statistics->num_columns() == 0 ||
+      statistics->column(0)->type_id() != Type::INT64) {
+    return Status::Invalid("Invalid IPC record batch statistics");
+  }
+  return statistics;
+}
+
+}  // namespace ipc
+}  // namespace arrow
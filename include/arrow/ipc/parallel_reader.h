@@ -0,0 +1,187 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Reading the record batches of an IPC file concurrently
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "arrow/io/interfaces.h"
+#include "arrow/ipc/options.h"
+#include "arrow/ipc/reader.h"
+#include "arrow/record_batch.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/table.h"
+#include "arrow/util/async_generator.h"
+#include "arrow/util/future.h"
+#include "arrow/util/thread_pool.h"
+
+namespace arrow {
+namespace ipc {
+
+/// \brief EXPERIMENTAL: Options for MakeParallelRecordBatchGenerator()
+struct ParallelReadOptions {
+  /// \brief The number of record batches read ahead of the consumer, hence
+  /// decoded concurrently, or 0 for the capacity of the executor
+  int readahead = 0;
+
+  /// \brief Validate each batch with RecordBatch::Validate()
+  bool validate = true;
+
+  /// \brief Validate each batch with RecordBatch::ValidateFull() instead,
+  /// which also checks the data (e.g. offsets and UTF8)
+  bool validate_full = false;
+
+  /// \brief The executor running the read tasks, or null for the CPU thread
+  /// pool
+  ::arrow::internal::Executor* executor = NULLPTR;
+};
+
+namespace internal {
+
+// RecordBatchFileReaders of the same file, each used by one task at a time
+class FileReaderPool {
+ public:
+  FileReaderPool(std::shared_ptr<io::RandomAccessFile> file,
+                 const IpcReadOptions& options,
+                 std::shared_ptr<RecordBatchFileReader> first_reader)
+      : file_(std::move(file)), options_(options) {
+    readers_.push_back(std::move(first_reader));
+  }
+
+  Result<std::shared_ptr<RecordBatchFileReader>> Acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!readers_.empty()) {
+        auto reader = std::move(readers_.back());
+        readers_.pop_back();
+        return reader;
+      }
+    }
+    return RecordBatchFileReader::Open(file_, options_);
+  }
+
+  void Release(std::shared_ptr<RecordBatchFileReader> reader) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readers_.push_back(std::move(reader));
+  }
+
+ private:
+  std::shared_ptr<io::RandomAccessFile> file_;
+  const IpcReadOptions options_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<RecordBatchFileReader>> readers_;
+};
+
+// Read the batches of the file `first_reader` was opened on
+inline AsyncGenerator<std::shared_ptr<RecordBatch>> MakeParallelRecordBatchGenerator(
+    std::shared_ptr<RecordBatchFileReader> first_reader,
+    std::shared_ptr<io::RandomAccessFile> file, const IpcReadOptions& options,
+    const ParallelReadOptions& parallel_options) {
+  const int num_batches = first_reader->num_record_batches();
+  auto executor = parallel_options.executor != NULLPTR
+                      ? parallel_options.executor
+                      : ::arrow::internal::GetCpuThreadPool();
+  const int readahead = parallel_options.readahead > 0 ? parallel_options.readahead
+                                                       : executor->GetCapacity();
+  auto readers = std::make_shared<FileReaderPool>(std::move(file), options,
+                                                  std::move(first_reader));
+  auto next_index = std::make_shared<std::atomic<int>>(0);
+
+  auto read_batch =
+      [readers, parallel_options](int index) -> Result<std::shared_ptr<RecordBatch>> {
+    ARROW_ASSIGN_OR_RAISE(auto reader, readers->Acquire());
+    auto maybe_batch = reader->ReadRecordBatch(index);
+    // A reader which failed may be in an inconsistent state
+    if (maybe_batch.ok()) readers->Release(std::move(reader));
+    ARROW_ASSIGN_OR_RAISE(auto batch, std::move(maybe_batch));
+    if (parallel_options.validate_full) {
+      RETURN_NOT_OK(batch->ValidateFull());
+    } else if (parallel_options.validate) {
+      RETURN_NOT_OK(batch->Validate());
+    }
+    return batch;
+  };
+  // Async-reentrant: each call claims the next batch and submits its task
+  AsyncGenerator<std::shared_ptr<RecordBatch>> source =
+      [executor, num_batches, next_index, read_batch]() {
+        const int index = next_index->fetch_add(1);
+        if (index >= num_batches) {
+          next_index->store(num_batches);
+          return AsyncGeneratorEnd<std::shared_ptr<RecordBatch>>();
+        }
+        return DeferNotOk(executor->Submit(read_batch, index));
+      };
+  return MakeReadaheadGenerator(std::move(source), std::max(1, readahead));
+}
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: Read the record batches of an IPC file (or Feather V2
+/// file) concurrently
+///
+/// IpcReadOptions::use_threads only decompresses the buffers of one batch in
+/// parallel, and RecordBatchFileReader reads batches one after the other.
+/// The returned generator instead reads, decompresses, decodes and
+/// validates up to `readahead` batches at once on the executor, and yields
+/// them in file order.
+///
+/// A RecordBatchFileReader is not thread-safe, so each concurrent task uses
+/// a reader of its own, opened on `file` when first needed: opening reads the
+/// footer again and each reader loads the dictionaries of the file on its
+/// first batch.  Since batches are decoded in parallel, the readers decompress
+/// each batch on the task's thread, ignoring `options.use_threads`.
+///
+/// `file` must support concurrent ReadAt() calls, as RandomAccessFile
+/// implementations do.
+inline Result<AsyncGenerator<std::shared_ptr<RecordBatch>>>
+MakeParallelRecordBatchGenerator(std::shared_ptr<io::RandomAccessFile> file,
+                                 IpcReadOptions options = IpcReadOptions::Defaults(),
+                                 const ParallelReadOptions& parallel_options = {}) {
+  options.use_threads = false;
+  ARROW_ASSIGN_OR_RAISE(auto first_reader, RecordBatchFileReader::Open(file, options));
+  return internal::MakeParallelRecordBatchGenerator(
+      std::move(first_reader), std::move(file), options, parallel_options);
+}
+
+/// \brief EXPERIMENTAL: Read a whole IPC file (or Feather V2 file) into a
+/// Table, decoding its record batches concurrently
+///
+/// \see MakeParallelRecordBatchGenerator
+inline Result<std::shared_ptr<Table>> ReadTableParallel(
+    std::shared_ptr<io::RandomAccessFile> file,
+    IpcReadOptions options = IpcReadOptions::Defaults(),
+    const ParallelReadOptions& parallel_options = {}) {
+  options.use_threads = false;
+  ARROW_ASSIGN_OR_RAISE(auto first_reader, RecordBatchFileReader::Open(file, options));
+  auto schema = first_reader->schema();
+  auto generator = internal::MakeParallelRecordBatchGenerator(
+      std::move(first_reader), std::move(file), options, parallel_options);
+  ARROW_ASSIGN_OR_RAISE(auto batches,
+                        CollectAsyncGenerator(std::move(generator)).result());
+  return Table::FromRecordBatches(std::move(schema), std::move(batches));
+}
+
+}  // namespace ipc
+}  // namespace arrow
@@ -545,6 +545,123 @@ void ByteStreamSplitEncodeAvx512(const uint8_t* raw_values, const size_t num_val
 }
 #endif  // ARROW_HAVE_AVX512
 
+#if defined(ARROW_HAVE_SSE4_2)
+// Width-generic variants for 2, 4, 8 and 16 streams, operating on raw bytes so
+// that they apply to any fixed-width type (INT32, INT64, FLOAT16, DECIMAL...).
+template <int kNumStreams>
+void ByteStreamSplitDecodeSse2Width(const uint8_t* data, int64_t num_values,
+                                    int64_t stride, uint8_t* out) {
+  static_assert(kNumStreams == 2 || kNumStreams == 4 || kNumStreams == 8 ||
+                    kNumStreams == 16,
+                "Invalid number of streams.");
+  constexpr int kNumStreamsLog2 =
+      kNumStreams == 16 ? 4 : (kNumStreams == 8 ? 3 : (kNumStreams == 4 ? 2 : 1));
+  constexpr int kNumStreamsHalf = kNumStreams / 2;
+  constexpr int64_t kValuesPerBlock = static_cast<int64_t>(sizeof(__m128i));
+  const int64_t num_blocks = num_values / kValuesPerBlock;
+
+  // First handle suffix.
+  for (int64_t i = num_blocks * kValuesPerBlock; i < num_values; ++i) {
+    for (int b = 0; b < kNumStreams; ++b) {
+      out[i * kNumStreams + b] = data[b * stride + i];
+    }
+  }
+
+  // Same hierarchical unpacking as ByteStreamSplitDecodeSse2(), for any power
+  // of two number of streams.
+  __m128i stage[kNumStreamsLog2 + 1][kNumStreams];
+  for (int64_t i = 0; i < num_blocks; ++i) {
+    for (int j = 0; j < kNumStreams; ++j) {
+      stage[0][j] = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(&data[i * kValuesPerBlock + j * stride]));
+    }
+    for (int step = 0; step < kNumStreamsLog2; ++step) {
+      for (int j = 0; j < kNumStreamsHalf; ++j) {
+        stage[step + 1][j * 2] =
+            _mm_unpacklo_epi8(stage[step][j], stage[step][kNumStreamsHalf + j]);
+        stage[step + 1][j * 2 + 1] =
+            _mm_unpackhi_epi8(stage[step][j], stage[step][kNumStreamsHalf + j]);
+      }
+    }
+    for (int j = 0; j < kNumStreams; ++j) {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(&out[(i * kNumStreams + j) * sizeof(__m128i)]),
+          stage[kNumStreamsLog2][j]);
+    }
+  }
+}
+
+template <int kNumStreams>
+void ByteStreamSplitEncodeSse2Width(const uint8_t* raw_values, int64_t num_values,
+                                    uint8_t* output_buffer_raw) {
+  static_assert(kNumStreams == 2 || kNumStreams == 4 || kNumStreams == 8 ||
+                    kNumStreams == 16,
+                "Invalid number of streams.");
+  constexpr int kNumStreamsLog2 =
+      kNumStreams == 16 ? 4 : (kNumStreams == 8 ? 3 : (kNumStreams == 4 ? 2 : 1));
+  constexpr int kNumStreamsHalf = kNumStreams / 2;
+  // Number of values held by one input register
+  constexpr int kValuesPerRegister = static_cast<int>(sizeof(__m128i)) / kNumStreams;
+  constexpr int64_t kValuesPerBlock = static_cast<int64_t>(sizeof(__m128i));
+  const int64_t num_blocks = num_values / kValuesPerBlock;
+
+  // First handle suffix.
+  for (int64_t i = num_blocks * kValuesPerBlock; i < num_values; ++i) {
+    for (int j = 0; j < kNumStreams; ++j) {
+      output_buffer_raw[j * num_values + i] = raw_values[i * kNumStreams + j];
+    }
+  }
+
+  // Each input register is first shuffled so that it holds kNumStreams groups of
+  // kValuesPerRegister bytes, one group per stream.  Gathering group j of every
+  // register into output stream j is then a transpose of a square matrix of
+  // groups, done with unpacks of group-sized elements.
+  alignas(16) uint8_t shuffle_mask[sizeof(__m128i)];
+  for (int j = 0; j < kNumStreams; ++j) {
+    for (int v = 0; v < kValuesPerRegister; ++v) {
+      shuffle_mask[j * kValuesPerRegister + v] =
+          static_cast<uint8_t>(v * kNumStreams + j);
+    }
+  }
+  const __m128i group_by_stream =
+      _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle_mask));
+
+  __m128i stage[kNumStreamsLog2 + 1][kNumStreams];
+  for (int64_t i = 0; i < num_blocks; ++i) {
+    for (int j = 0; j < kNumStreams; ++j) {
+      stage[0][j] = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+              &raw_values[(i * kNumStreams + j) * sizeof(__m128i)])),
+          group_by_stream);
+    }
+    for (int step = 0; step < kNumStreamsLog2; ++step) {
+      for (int j = 0; j < kNumStreamsHalf; ++j) {
+        const __m128i a = stage[step][j];
+        const __m128i b = stage[step][kNumStreamsHalf + j];
+        if (kValuesPerRegister == 1) {
+          stage[step + 1][j * 2] = _mm_unpacklo_epi8(a, b);
+          stage[step + 1][j * 2 + 1] = _mm_unpackhi_epi8(a, b);
+        } else if (kValuesPerRegister == 2) {
+          stage[step + 1][j * 2] = _mm_unpacklo_epi16(a, b);
+          stage[step + 1][j * 2 + 1] = _mm_unpackhi_epi16(a, b);
+        } else if (kValuesPerRegister == 4) {
+          stage[step + 1][j * 2] = _mm_unpacklo_epi32(a, b);
+          stage[step + 1][j * 2 + 1] = _mm_unpackhi_epi32(a, b);
+        } else {
+          stage[step + 1][j * 2] = _mm_unpacklo_epi64(a, b);
+          stage[step + 1][j * 2 + 1] = _mm_unpackhi_epi64(a, b);
+        }
+      }
+    }
+    for (int j = 0; j < kNumStreams; ++j) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(
+                           &output_buffer_raw[j * num_values + i * kValuesPerBlock]),
+                       stage[kNumStreamsLog2][j]);
+    }
+  }
+}
+#endif  // ARROW_HAVE_SSE4_2
+
 #if defined(ARROW_HAVE_SIMD_SPLIT)
 template <typename T>
 void inline ByteStreamSplitDecodeSimd(const uint8_t* data, int64_t num_values,
@@ -621,6 +738,134 @@ void inline ByteStreamSplitDecode(const uint8_t* data, int64_t num_values, int64
 #endif
 }
 
+template <int kNumStreams>
+void ByteStreamSplitEncodeScalarWidth(const uint8_t* raw_values, int64_t num_values,
+                                      uint8_t* output_buffer_raw) {
+  for (int64_t i = 0; i < num_values; ++i) {
+    for (int j = 0; j < kNumStreams; ++j) {
+      output_buffer_raw[j * num_values + i] = raw_values[i * kNumStreams + j];
+    }
+  }
+}
+
+template <int kNumStreams>
+void ByteStreamSplitDecodeScalarWidth(const uint8_t* data, int64_t num_values,
+                                      int64_t stride, uint8_t* out) {
+  for (int64_t i = 0; i < num_values; ++i) {
+    for (int b = 0; b < kNumStreams; ++b) {
+      out[i * kNumStreams + b] = data[b * stride + i];
+    }
+  }
+}
+
+// Fallback for widths without a specialized kernel, e.g. FIXED_LEN_BYTE_ARRAY
+// columns of odd lengths.  Values are processed in blocks so that the strided
+// side of the transpose stays in cache while each stream is visited.
+inline void ByteStreamSplitEncodeScalarDynamic(const uint8_t* raw_values, int width,
+                                               int64_t num_values,
+                                               uint8_t* output_buffer_raw) {
+  constexpr int64_t kBlockSize = 128;
+  for (int64_t block = 0; block < num_values; block += kBlockSize) {
+    const int64_t block_end = std::min(block + kBlockSize, num_values);
+    for (int j = 0; j < width; ++j) {
+      uint8_t* stream = output_buffer_raw + j * num_values;
+      for (int64_t i = block; i < block_end; ++i) {
+        stream[i] = raw_values[i * width + j];
+      }
+    }
+  }
+}
+
+inline void ByteStreamSplitDecodeScalarDynamic(const uint8_t* data, int width,
+                                               int64_t num_values, int64_t stride,
+                                               uint8_t* out) {
+  constexpr int64_t kBlockSize = 128;
+  for (int64_t block = 0; block < num_values; block += kBlockSize) {
+    const int64_t block_end = std::min(block + kBlockSize, num_values);
+    for (int b = 0; b < width; ++b) {
+      const uint8_t* stream = data + b * stride;
+      for (int64_t i = block; i < block_end; ++i) {
+        out[i * width + b] = stream[i];
+      }
+    }
+  }
+}
+
+/// \brief Encode `num_values` values of `width` bytes each into `width` streams
+///
+/// Widths 4 and 8 use the same kernels as float and double, widths 2 and 16
+/// have their own vectorized transposes and any other width is handled by a
+/// scalar loop.  `output_buffer_raw` must hold `width * num_values` bytes.
+///
+/// Note that Parquet files written by this version may only use the
+/// BYTE_STREAM_SPLIT encoding for FLOAT and DOUBLE columns.
+inline void ByteStreamSplitEncode(const uint8_t* raw_values, int width,
+                                  int64_t num_values, uint8_t* output_buffer_raw) {
+  switch (width) {
+    case 1:
+      std::copy(raw_values, raw_values + num_values, output_buffer_raw);
+      return;
+    case 2:
+#if defined(ARROW_HAVE_SIMD_SPLIT)
+      return ByteStreamSplitEncodeSse2Width<2>(raw_values, num_values,
+                                               output_buffer_raw);
+#else
+      return ByteStreamSplitEncodeScalarWidth<2>(raw_values, num_values,
+                                                 output_buffer_raw);
+#endif
+    case 4:
+      return ByteStreamSplitEncode<uint32_t>(raw_values, static_cast<size_t>(num_values),
+                                             output_buffer_raw);
+    case 8:
+      return ByteStreamSplitEncode<uint64_t>(raw_values, static_cast<size_t>(num_values),
+                                             output_buffer_raw);
+    case 16:
+#if defined(ARROW_HAVE_SIMD_SPLIT)
+      return ByteStreamSplitEncodeSse2Width<16>(raw_values, num_values,
+                                                output_buffer_raw);
+#else
+      return ByteStreamSplitEncodeScalarWidth<16>(raw_values, num_values,
+                                                  output_buffer_raw);
+#endif
+    default:
+      return ByteStreamSplitEncodeScalarDynamic(raw_values, width, num_values,
+                                                output_buffer_raw);
+  }
+}
+
+/// \brief Decode `num_values` values of `width` bytes each from `width` streams
+/// starting `stride` bytes apart
+///
+/// `out` must hold `width * num_values` bytes.
+inline void ByteStreamSplitDecode(const uint8_t* data, int width, int64_t num_values,
+                                  int64_t stride, uint8_t* out) {
+  switch (width) {
+    case 1:
+      std::copy(data, data + num_values, out);
+      return;
+    case 2:
+#if defined(ARROW_HAVE_SIMD_SPLIT)
+      return ByteStreamSplitDecodeSse2Width<2>(data, num_values, stride, out);
+#else
+      return ByteStreamSplitDecodeScalarWidth<2>(data, num_values, stride, out);
+#endif
+    case 4:
+      return ByteStreamSplitDecode(data, num_values, stride,
+                                   reinterpret_cast<uint32_t*>(out));
+    case 8:
+      return ByteStreamSplitDecode(data, num_values, stride,
+                                   reinterpret_cast<uint64_t*>(out));
+    case 16:
+#if defined(ARROW_HAVE_SIMD_SPLIT)
+      return ByteStreamSplitDecodeSse2Width<16>(data, num_values, stride, out);
+#else
+      return ByteStreamSplitDecodeScalarWidth<16>(data, num_values, stride, out);
+#endif
+    default:
+      return ByteStreamSplitDecodeScalarDynamic(data, width, num_values, stride, out);
+  }
+}
+
 }  // namespace internal
 }  // namespace util
 }  // namespace arrow
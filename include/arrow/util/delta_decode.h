@@ -0,0 +1,252 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Decoding kernels for the DELTA_BINARY_PACKED, DELTA_LENGTH_BYTE_ARRAY and
+// DELTA_BYTE_ARRAY Parquet encodings.
+//
+// These are standalone helpers: the Parquet decoders compiled into the
+// library do not call them.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "arrow/status.h"
+#include "arrow/util/bit_stream_utils.h"
+#include "arrow/util/macros.h"
+#include "arrow/util/simd.h"
+
+#if defined(ARROW_HAVE_AVX2) || defined(ARROW_HAVE_SSE4_2)
+// Enable the SIMD prefix sums for the DELTA_* decoders
+#define ARROW_HAVE_SIMD_DELTA
+#endif
+
+namespace arrow {
+namespace util {
+namespace internal {
+
+// ----------------------------------------------------------------------
+// Prefix sums
+//
+// All kernels compute out[i] = last + sum(deltas[0..i]) + (i + 1) * min_delta
+// using wrapping (unsigned) arithmetic, as mandated by the Parquet spec, and
+// return the last value written.  `deltas` and `out` may alias.
+
+template <typename T>
+T DeltaPrefixSumScalar(const T* deltas, int64_t num_values, T min_delta, T last,
+                       T* out) {
+  static_assert(std::is_integral<T>::value, "DeltaPrefixSum requires integers");
+  using U = std::make_unsigned_t<T>;
+  U value = static_cast<U>(last);
+  const U min = static_cast<U>(min_delta);
+  for (int64_t i = 0; i < num_values; ++i) {
+    value += static_cast<U>(deltas[i]) + min;
+    out[i] = static_cast<T>(value);
+  }
+  return static_cast<T>(value);
+}
+
+#if defined(ARROW_HAVE_SSE4_2)
+inline int32_t DeltaPrefixSumSse(const int32_t* deltas, int64_t num_values,
+                                 int32_t min_delta, int32_t last, int32_t* out) {
+  const __m128i min = _mm_set1_epi32(min_delta);
+  __m128i carry = _mm_set1_epi32(last);
+  int64_t i = 0;
+  for (; i + 4 <= num_values; i += 4) {
+    __m128i x = _mm_add_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + i)), min);
+    // Log-step inclusive scan: ABCD -> A,A+B,B+C,C+D -> A,A+B,A+B+C,A+B+C+D
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi32(x, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+    carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  last = _mm_cvtsi128_si32(carry);
+  return DeltaPrefixSumScalar(deltas + i, num_values - i, min_delta, last, out + i);
+}
+
+inline int64_t DeltaPrefixSumSse(const int64_t* deltas, int64_t num_values,
+                                 int64_t min_delta, int64_t last, int64_t* out) {
+  const __m128i min = _mm_set1_epi64x(min_delta);
+  __m128i carry = _mm_set1_epi64x(last);
+  int64_t i = 0;
+  for (; i + 2 <= num_values; i += 2) {
+    __m128i x = _mm_add_epi64(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + i)), min);
+    x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi64(x, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+    carry = _mm_unpackhi_epi64(x, x);
+  }
+  // _mm_cvtsi128_si64 is unavailable on 32-bit targets
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&last), carry);
+  return DeltaPrefixSumScalar(deltas + i, num_values - i, min_delta, last, out + i);
+}
+#endif  // ARROW_HAVE_SSE4_2
+
+#if defined(ARROW_HAVE_AVX2)
+inline int32_t DeltaPrefixSumAvx2(const int32_t* deltas, int64_t num_values,
+                                  int32_t min_delta, int32_t last, int32_t* out) {
+  const __m256i min = _mm256_set1_epi32(min_delta);
+  const __m256i lane0_last = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+  const __m256i broadcast_last = _mm256_set1_epi32(7);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i carry = _mm256_set1_epi32(last);
+  int64_t i = 0;
+  for (; i + 8 <= num_values; i += 8) {
+    __m256i x = _mm256_add_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(deltas + i)), min);
+    // Byte shifts operate per 128-bit lane: scan each lane, then propagate
+    // the running total of the low lane into the high lane.
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    x = _mm256_add_epi32(
+        x, _mm256_blend_epi32(zero, _mm256_permutevar8x32_epi32(x, lane0_last), 0xF0));
+    x = _mm256_add_epi32(x, carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+    carry = _mm256_permutevar8x32_epi32(x, broadcast_last);
+  }
+  last = _mm_cvtsi128_si32(_mm256_castsi256_si128(carry));
+  return DeltaPrefixSumScalar(deltas + i, num_values - i, min_delta, last, out + i);
+}
+
+inline int64_t DeltaPrefixSumAvx2(const int64_t* deltas, int64_t num_values,
+                                  int64_t min_delta, int64_t last, int64_t* out) {
+  const __m256i min = _mm256_set1_epi64x(min_delta);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i carry = _mm256_set1_epi64x(last);
+  int64_t i = 0;
+  for (; i + 4 <= num_values; i += 4) {
+    __m256i x = _mm256_add_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(deltas + i)), min);
+    x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+    x = _mm256_add_epi64(
+        x, _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 1, 1, 1)),
+                              0xF0));
+    x = _mm256_add_epi64(x, carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+    carry = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&last), _mm256_castsi256_si128(carry));
+  return DeltaPrefixSumScalar(deltas + i, num_values - i, min_delta, last, out + i);
+}
+#endif  // ARROW_HAVE_AVX2
+
+template <typename T>
+inline T DeltaPrefixSum(const T* deltas, int64_t num_values, T min_delta, T last,
+                        T* out) {
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Invalid delta width.");
+#if defined(ARROW_HAVE_SIMD_DELTA)
+  using Int = std::conditional_t<sizeof(T) == 4, int32_t, int64_t>;
+#endif
+#if defined(ARROW_HAVE_AVX2)
+  return static_cast<T>(DeltaPrefixSumAvx2(
+      reinterpret_cast<const Int*>(deltas), num_values, static_cast<Int>(min_delta),
+      static_cast<Int>(last), reinterpret_cast<Int*>(out)));
+#elif defined(ARROW_HAVE_SSE4_2)
+  return static_cast<T>(DeltaPrefixSumSse(
+      reinterpret_cast<const Int*>(deltas), num_values, static_cast<Int>(min_delta),
+      static_cast<Int>(last), reinterpret_cast<Int*>(out)));
+#else
+  return DeltaPrefixSumScalar(deltas, num_values, min_delta, last, out);
+#endif
+}
+
+// ----------------------------------------------------------------------
+// DELTA_BINARY_PACKED
+
+/// \brief Decode one DELTA_BINARY_PACKED miniblock
+///
+/// Unpacks up to `num_values` deltas of `bit_width` bits through
+/// BitReader::GetBatch, then adds `min_delta` and accumulates them onto
+/// `*last_value` in place, in a single vectorized pass.  GetBatch unpacks
+/// through unpack32, which dispatches to the AVX2 / AVX-512 unpackers at
+/// runtime, for 32-bit values and for 64-bit values of up to 32 bits; wider
+/// 64-bit values go through the scalar unpack64.
+///
+/// \return the number of values decoded, which is less than `num_values`
+/// only if the reader ran out of data
+template <typename T>
+int DeltaBitPackedDecodeMiniblock(bit_util::BitReader* reader, int bit_width,
+                                  T min_delta, T* last_value, T* out, int num_values) {
+  int decoded = num_values;
+  if (bit_width == 0) {
+    // All deltas equal min_delta: no payload bytes to unpack
+    std::memset(out, 0, sizeof(T) * num_values);
+  } else {
+    decoded = reader->GetBatch(bit_width, out, num_values);
+  }
+  *last_value = DeltaPrefixSum(out, decoded, min_delta, *last_value, out);
+  return decoded;
+}
+
+// ----------------------------------------------------------------------
+// DELTA_BYTE_ARRAY
+
+/// \brief Number of bytes needed to hold the reconstructed DELTA_BYTE_ARRAY values
+inline int64_t DeltaByteArrayDataLength(const int32_t* prefix_lengths,
+                                        const std::string_view* suffixes,
+                                        int64_t num_values) {
+  int64_t length = 0;
+  for (int64_t i = 0; i < num_values; ++i) {
+    length += prefix_lengths[i] + static_cast<int64_t>(suffixes[i].size());
+  }
+  return length;
+}
+
+/// \brief Reconstruct DELTA_BYTE_ARRAY values into a single contiguous buffer
+///
+/// Value i is made of the first prefix_lengths[i] bytes of value i - 1 (of
+/// `last_value` for i == 0) followed by suffixes[i].  All values are written
+/// back-to-back into `out`, which must hold at least DeltaByteArrayDataLength()
+/// bytes, and `out_values` receives views into it.  Since each value's
+/// predecessor is located immediately before it, no per-value allocation or
+/// intermediate string is needed.
+inline Status DeltaByteArrayReconstruct(const int32_t* prefix_lengths,
+                                        const std::string_view* suffixes,
+                                        int64_t num_values, std::string_view last_value,
+                                        uint8_t* out, std::string_view* out_values) {
+  std::string_view previous = last_value;
+  for (int64_t i = 0; i < num_values; ++i) {
+    const int32_t prefix_length = prefix_lengths[i];
+    if (ARROW_PREDICT_FALSE(prefix_length < 0 ||
+                            static_cast<size_t>(prefix_length) > previous.size())) {
+      return Status::Invalid("DELTA_BYTE_ARRAY: invalid prefix length ", prefix_length,
+                             " for previous value of length ", previous.size());
+    }
+    const std::string_view suffix = suffixes[i];
+    if (prefix_length > 0) {
+      std::memcpy(out, previous.data(), prefix_length);
+    }
+    if (!suffix.empty()) {
+      std::memcpy(out + prefix_length, suffix.data(), suffix.size());
+    }
+    previous = std::string_view(reinterpret_cast<const char*>(out),
+                                prefix_length + suffix.size());
+    out_values[i] = previous;
+    out += previous.size();
+  }
+  return Status::OK();
+}
+
+}  // namespace internal
+}  // namespace util
+}  // namespace arrow
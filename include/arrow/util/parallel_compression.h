@@ -0,0 +1,212 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Asynchronous and multi-threaded one-shot compression on top of Codec
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "arrow/buffer.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/compression.h"
+#include "arrow/util/future.h"
+#include "arrow/util/parallel.h"
+#include "arrow/util/thread_pool.h"
+
+namespace arrow {
+namespace util {
+
+/// \brief EXPERIMENTAL: Compress a buffer on an executor
+///
+/// The returned buffer holds exactly the compressed bytes.  Together with
+/// ParallelCodec this lets callers overlap the compression of a page or record
+/// batch body with the encoding of the next one and with I/O.  `codec` must be
+/// safe to use concurrently from several threads, which all built-in codecs are
+/// for one-shot compression.
+inline Future<std::shared_ptr<Buffer>> CompressAsync(
+    std::shared_ptr<Codec> codec, std::shared_ptr<Buffer> input,
+    ::arrow::internal::Executor* executor = ::arrow::internal::GetCpuThreadPool(),
+    MemoryPool* pool = default_memory_pool()) {
+  return DeferNotOk(executor->Submit(
+      [codec = std::move(codec), input = std::move(input),
+       pool]() -> Result<std::shared_ptr<Buffer>> {
+        const int64_t max_length = codec->MaxCompressedLen(input->size(), input->data());
+        ARROW_ASSIGN_OR_RAISE(auto output, AllocateResizableBuffer(max_length, pool));
+        ARROW_ASSIGN_OR_RAISE(
+            const int64_t length,
+            codec->Compress(input->size(), input->data(), max_length,
+                            output->mutable_data()));
+        RETURN_NOT_OK(output->Resize(length, /*shrink_to_fit=*/true));
+        return std::shared_ptr<Buffer>(std::move(output));
+      }));
+}
+
+/// \brief EXPERIMENTAL: A Codec compressing large ZSTD inputs on several threads
+///
+/// Inputs larger than `block_size` are cut into blocks which are compressed
+/// concurrently on `executor` as independent ZSTD frames.  A sequence of
+/// frames is itself a valid ZSTD stream, so the output is decompressed by any
+/// ZSTD decoder, including the wrapped codec's one-shot Decompress().  The
+/// compression ratio drops slightly since blocks do not share history.
+///
+/// Formats that do not allow concatenated frames (notably LZ4_FRAME, whose
+/// decoder in this library expects exactly one frame) are compressed on the
+/// calling thread; use CompressAsync() to overlap their compression with other
+/// work instead.  Streaming compressors and decompressors are those of the
+/// wrapped codec.
+///
+/// Since it is a plain Codec, an instance can be installed as
+/// ipc::IpcWriteOptions::codec.  When Compress() is called from a thread of
+/// `executor` itself, as the IPC writer does with its default `use_threads`
+/// on the CPU thread pool, the blocks are compressed on the calling thread
+/// rather than waited for, which would deadlock once the pool is full.  The
+/// blocks are then only compressed in parallel with IpcWriteOptions::use_threads
+/// set to false, or with a dedicated `executor`.
+class ParallelCodec : public Codec {
+ public:
+  static constexpr int64_t kDefaultBlockSize = 4 * 1024 * 1024;
+
+  explicit ParallelCodec(
+      std::shared_ptr<Codec> codec, int64_t block_size = kDefaultBlockSize,
+      ::arrow::internal::Executor* executor = ::arrow::internal::GetCpuThreadPool())
+      : codec_(std::move(codec)), block_size_(block_size), executor_(executor) {}
+
+  /// \brief Create a ParallelCodec wrapping a new codec of the given type
+  static Result<std::unique_ptr<ParallelCodec>> Make(
+      Compression::type type, int compression_level = kUseDefaultCompressionLevel,
+      int64_t block_size = kDefaultBlockSize,
+      ::arrow::internal::Executor* executor = ::arrow::internal::GetCpuThreadPool()) {
+    if (block_size <= 0) {
+      return Status::Invalid("ParallelCodec block size must be positive");
+    }
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<Codec> codec,
+                          Codec::Create(type, compression_level));
+    return std::make_unique<ParallelCodec>(std::move(codec), block_size, executor);
+  }
+
+  const std::shared_ptr<Codec>& wrapped_codec() const { return codec_; }
+
+  int64_t block_size() const { return block_size_; }
+
+  int minimum_compression_level() const override {
+    return codec_->minimum_compression_level();
+  }
+  int maximum_compression_level() const override {
+    return codec_->maximum_compression_level();
+  }
+  int default_compression_level() const override {
+    return codec_->default_compression_level();
+  }
+  int compression_level() const override { return codec_->compression_level(); }
+  Compression::type compression_type() const override {
+    return codec_->compression_type();
+  }
+
+  Result<int64_t> Decompress(int64_t input_len, const uint8_t* input,
+                             int64_t output_buffer_len,
+                             uint8_t* output_buffer) override {
+    return codec_->Decompress(input_len, input, output_buffer_len, output_buffer);
+  }
+
+  int64_t MaxCompressedLen(int64_t input_len, const uint8_t* input) override {
+    if (!IsSplit(input_len)) {
+      return codec_->MaxCompressedLen(input_len, input);
+    }
+    int64_t length = 0;
+    for (int64_t offset = 0; offset < input_len; offset += block_size_) {
+      const int64_t block = std::min(block_size_, input_len - offset);
+      length += codec_->MaxCompressedLen(block, input + offset);
+    }
+    return length;
+  }
+
+  Result<int64_t> Compress(int64_t input_len, const uint8_t* input,
+                           int64_t output_buffer_len, uint8_t* output_buffer) override {
+    if (!IsSplit(input_len)) {
+      return codec_->Compress(input_len, input, output_buffer_len, output_buffer);
+    }
+    // Each block is compressed into its own slot of the output, sized with the
+    // block's MaxCompressedLen(); the frames are then packed together.
+    const int num_blocks = static_cast<int>((input_len + block_size_ - 1) / block_size_);
+    std::vector<int64_t> slot_offsets(num_blocks + 1, 0);
+    for (int i = 0; i < num_blocks; ++i) {
+      const int64_t offset = i * block_size_;
+      slot_offsets[i + 1] =
+          slot_offsets[i] +
+          codec_->MaxCompressedLen(std::min(block_size_, input_len - offset),
+                                   input + offset);
+    }
+    if (slot_offsets[num_blocks] > output_buffer_len) {
+      return Status::Invalid("Output buffer too small for ParallelCodec: ",
+                             output_buffer_len, " < ", slot_offsets[num_blocks]);
+    }
+    std::vector<int64_t> lengths(num_blocks);
+    auto compress_block = [&](int i) -> Status {
+      const int64_t offset = i * block_size_;
+      ARROW_ASSIGN_OR_RAISE(
+          lengths[i],
+          codec_->Compress(std::min(block_size_, input_len - offset), input + offset,
+                           slot_offsets[i + 1] - slot_offsets[i],
+                           output_buffer + slot_offsets[i]));
+      return Status::OK();
+    };
+    if (executor_->OwnsThisThread()) {
+      // Waiting for tasks of our own executor could deadlock
+      for (int i = 0; i < num_blocks; ++i) {
+        RETURN_NOT_OK(compress_block(i));
+      }
+    } else {
+      RETURN_NOT_OK(
+          ::arrow::internal::ParallelFor(num_blocks, compress_block, executor_));
+    }
+    int64_t length = lengths[0];
+    for (int i = 1; i < num_blocks; ++i) {
+      std::memmove(output_buffer + length, output_buffer + slot_offsets[i], lengths[i]);
+      length += lengths[i];
+    }
+    return length;
+  }
+
+  Result<std::shared_ptr<Compressor>> MakeCompressor() override {
+    return codec_->MakeCompressor();
+  }
+
+  Result<std::shared_ptr<Decompressor>> MakeDecompressor() override {
+    return codec_->MakeDecompressor();
+  }
+
+ private:
+  bool IsSplit(int64_t input_len) const {
+    return executor_ != NULLPTR && block_size_ > 0 && input_len > block_size_ &&
+           codec_->compression_type() == Compression::ZSTD;
+  }
+
+  std::shared_ptr<Codec> codec_;
+  const int64_t block_size_;
+  ::arrow::internal::Executor* executor_;
+};
+
+}  // namespace util
+}  // namespace arrow
@@ -0,0 +1,335 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// ZSTD compression with a trained dictionary.  Requires the zstd headers and
+// library: when <zstd.h> and <zdict.h> cannot be found, this header declares
+// nothing and ARROW_HAVE_ZSTD_DICTIONARY is left undefined.
+
+#pragma once
+
+#if defined(__has_include)
+#if __has_include(<zstd.h>) && __has_include(<zdict.h>)
+#define ARROW_HAVE_ZSTD_DICTIONARY
+#endif
+#endif
+
+#ifdef ARROW_HAVE_ZSTD_DICTIONARY
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "arrow/buffer.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/util/base64.h"
+#include "arrow/util/compression.h"
+#include "arrow/util/key_value_metadata.h"
+#include "arrow/util/logging.h"
+
+namespace arrow {
+namespace util {
+
+/// \brief Metadata key under which AttachZstdDictionary() stores a ZSTD
+/// dictionary, base64-encoded
+static constexpr char kZstdDictionaryMetadataKey[] = "compression.zstd_dictionary";
+
+/// Default dictionary size, the same as the zstd command line tool's
+static constexpr int64_t kDefaultZstdDictionarySize = 112640;
+
+/// Compression level used when none is given, the same as ZSTD codecs'
+static constexpr int kZstdDictionaryDefaultCompressionLevel = 1;
+
+/// \brief EXPERIMENTAL: Train a ZSTD dictionary from sample data
+///
+/// Samples should be representative of the payloads to compress, e.g. record
+/// batch bodies or Parquet data pages, and there should be at least a few
+/// hundred of them; zstd fails to train from too little data.
+inline Result<std::shared_ptr<Buffer>> TrainZstdDictionary(
+    const std::vector<std::shared_ptr<Buffer>>& samples,
+    int64_t max_dictionary_size = kDefaultZstdDictionarySize,
+    MemoryPool* pool = default_memory_pool()) {
+  std::string concatenated;
+  std::vector<size_t> sample_sizes;
+  sample_sizes.reserve(samples.size());
+  for (const auto& sample : samples) {
+    concatenated.append(reinterpret_cast<const char*>(sample->data()),
+                        static_cast<size_t>(sample->size()));
+    sample_sizes.push_back(static_cast<size_t>(sample->size()));
+  }
+  ARROW_ASSIGN_OR_RAISE(auto dictionary,
+                        AllocateResizableBuffer(max_dictionary_size, pool));
+  const size_t size = ZDICT_trainFromBuffer(
+      dictionary->mutable_data(), static_cast<size_t>(max_dictionary_size),
+      concatenated.data(), sample_sizes.data(),
+      static_cast<unsigned>(sample_sizes.size()));
+  if (ZDICT_isError(size)) {
+    return Status::Invalid("ZSTD dictionary training failed: ",
+                           ZDICT_getErrorName(size));
+  }
+  RETURN_NOT_OK(dictionary->Resize(static_cast<int64_t>(size), /*shrink_to_fit=*/true));
+  return std::shared_ptr<Buffer>(std::move(dictionary));
+}
+
+/// \brief EXPERIMENTAL: A ZSTD dictionary digested for compression and
+/// decompression
+///
+/// Digesting is expensive; build one instance per dictionary and share it
+/// between codecs.  This class is thread-safe.
+class ZstdDictionary {
+ public:
+  ~ZstdDictionary() {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+  }
+
+  static Result<std::shared_ptr<ZstdDictionary>> Make(
+      std::shared_ptr<Buffer> data,
+      int compression_level = kZstdDictionaryDefaultCompressionLevel) {
+    if (compression_level == kUseDefaultCompressionLevel) {
+      compression_level = kZstdDictionaryDefaultCompressionLevel;
+    }
+    std::shared_ptr<ZstdDictionary> dictionary(
+        new ZstdDictionary(std::move(data), compression_level));
+    const auto* bytes = dictionary->data_->data();
+    const auto size = static_cast<size_t>(dictionary->data_->size());
+    dictionary->cdict_ = ZSTD_createCDict(bytes, size, compression_level);
+    dictionary->ddict_ = ZSTD_createDDict(bytes, size);
+    if (dictionary->cdict_ == NULLPTR || dictionary->ddict_ == NULLPTR) {
+      return Status::Invalid("Invalid ZSTD dictionary");
+    }
+    return dictionary;
+  }
+
+  const std::shared_ptr<Buffer>& data() const { return data_; }
+  int compression_level() const { return compression_level_; }
+
+  /// \brief The dictionary ID recorded in frames, 0 for raw content dictionaries
+  uint32_t id() const { return ZSTD_getDictID_fromDict(data_->data(), data_->size()); }
+
+  const ZSTD_CDict* cdict() const { return cdict_; }
+  const ZSTD_DDict* ddict() const { return ddict_; }
+
+ private:
+  ZstdDictionary(std::shared_ptr<Buffer> data, int compression_level)
+      : data_(std::move(data)), compression_level_(compression_level) {}
+
+  std::shared_ptr<Buffer> data_;
+  int compression_level_;
+  ZSTD_CDict* cdict_ = NULLPTR;
+  ZSTD_DDict* ddict_ = NULLPTR;
+};
+
+/// \brief EXPERIMENTAL: One-shot ZSTD compression with a dictionary
+///
+/// Small payloads compress poorly with plain ZSTD as every frame starts
+/// without history; a dictionary trained on similar payloads provides it.
+/// Frames are standard ZSTD frames referencing the dictionary ID, so they can
+/// only be decompressed with the same dictionary, which is why the dictionary
+/// should travel with the data (see AttachZstdDictionary()).  Frames written
+/// without a dictionary decompress fine with this codec.
+///
+/// This is deliberately not a util::Codec: the IPC and Parquet readers pick
+/// their decompressor from the compression type recorded in the file, so
+/// frames written through ipc::IpcWriteOptions::codec would be labelled ZSTD
+/// yet be unreadable by them.  Use it for payloads the application frames and
+/// decompresses itself, e.g. with CompressBuffer() and DecompressBuffer().
+class ZstdDictionaryCodec {
+ public:
+  explicit ZstdDictionaryCodec(std::shared_ptr<ZstdDictionary> dictionary)
+      : dictionary_(std::move(dictionary)) {}
+
+  ~ZstdDictionaryCodec() {
+    for (auto* context : cctxs_) ZSTD_freeCCtx(context);
+    for (auto* context : dctxs_) ZSTD_freeDCtx(context);
+  }
+
+  const std::shared_ptr<ZstdDictionary>& dictionary() const { return dictionary_; }
+
+  int compression_level() const { return dictionary_->compression_level(); }
+
+  int64_t MaxCompressedLen(int64_t input_len) const {
+    return static_cast<int64_t>(ZSTD_compressBound(static_cast<size_t>(input_len)));
+  }
+
+  /// \brief Compress `input` into a single frame recording its content size
+  Result<int64_t> Compress(int64_t input_len, const uint8_t* input,
+                           int64_t output_buffer_len, uint8_t* output_buffer) {
+    ZSTD_CCtx* context = AcquireContext(&cctxs_, ZSTD_createCCtx);
+    const size_t ret = ZSTD_compress_usingCDict(
+        context, output_buffer, static_cast<size_t>(output_buffer_len), input,
+        static_cast<size_t>(input_len), dictionary_->cdict());
+    ReleaseContext(&cctxs_, context);
+    if (ZSTD_isError(ret)) {
+      return Status::IOError("ZSTD compression failed: ", ZSTD_getErrorName(ret));
+    }
+    return static_cast<int64_t>(ret);
+  }
+
+  /// \brief Decompress a frame whose decompressed size is `output_buffer_len`
+  Result<int64_t> Decompress(int64_t input_len, const uint8_t* input,
+                             int64_t output_buffer_len, uint8_t* output_buffer) {
+    if (output_buffer == NULLPTR) {
+      // We may pass a NULL 0-byte output buffer but some zstd versions demand
+      // a valid pointer: https://github.com/facebook/zstd/issues/1385
+      static uint8_t empty_buffer;
+      DCHECK_EQ(output_buffer_len, 0);
+      output_buffer = &empty_buffer;
+    }
+    ZSTD_DCtx* context = AcquireContext(&dctxs_, ZSTD_createDCtx);
+    const size_t ret = ZSTD_decompress_usingDDict(
+        context, output_buffer, static_cast<size_t>(output_buffer_len), input,
+        static_cast<size_t>(input_len), dictionary_->ddict());
+    ReleaseContext(&dctxs_, context);
+    if (ZSTD_isError(ret)) {
+      return Status::IOError("ZSTD decompression failed: ", ZSTD_getErrorName(ret));
+    }
+    if (static_cast<int64_t>(ret) != output_buffer_len) {
+      return Status::IOError("Corrupt ZSTD compressed data.");
+    }
+    return static_cast<int64_t>(ret);
+  }
+
+  /// \brief Compress `input` into a newly allocated frame
+  Result<std::shared_ptr<Buffer>> CompressBuffer(
+      const Buffer& input, MemoryPool* pool = default_memory_pool()) {
+    ARROW_ASSIGN_OR_RAISE(auto output,
+                          AllocateResizableBuffer(MaxCompressedLen(input.size()), pool));
+    ARROW_ASSIGN_OR_RAISE(const int64_t size,
+                          Compress(input.size(), input.data(), output->size(),
+                                   output->mutable_data()));
+    RETURN_NOT_OK(output->Resize(size, /*shrink_to_fit=*/true));
+    return std::shared_ptr<Buffer>(std::move(output));
+  }
+
+  /// \brief Decompress a frame written by Compress() or CompressBuffer()
+  ///
+  /// The decompressed size is read from the frame header.  Since the header
+  /// may come from an untrusted source, frames claiming more than
+  /// `max_decompressed_size` bytes are rejected before allocating anything.
+  Result<std::shared_ptr<Buffer>> DecompressBuffer(
+      const Buffer& input, int64_t max_decompressed_size,
+      MemoryPool* pool = default_memory_pool()) {
+    const unsigned long long content_size =  // NOLINT(runtime/int)
+        ZSTD_getFrameContentSize(input.data(), static_cast<size_t>(input.size()));
+    if (content_size == ZSTD_CONTENTSIZE_ERROR ||
+        content_size == ZSTD_CONTENTSIZE_UNKNOWN ||
+        content_size > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+      return Status::IOError("Invalid ZSTD frame header");
+    }
+    const auto size = static_cast<int64_t>(content_size);
+    if (size > max_decompressed_size) {
+      return Status::Invalid("ZSTD frame decompresses to ", size,
+                             " bytes, more than the maximum of ", max_decompressed_size);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto output, AllocateBuffer(size, pool));
+    RETURN_NOT_OK(
+        Decompress(input.size(), input.data(), size, output->mutable_data()).status());
+    return std::shared_ptr<Buffer>(std::move(output));
+  }
+
+ private:
+  // Contexts are not thread-safe but are costly to create for small payloads:
+  // keep the idle ones around for reuse.
+  template <typename Context>
+  Context* AcquireContext(std::vector<Context*>* pool, Context* (*create)()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!pool->empty()) {
+        Context* context = pool->back();
+        pool->pop_back();
+        return context;
+      }
+    }
+    return create();
+  }
+
+  template <typename Context>
+  void ReleaseContext(std::vector<Context*>* pool, Context* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pool->push_back(context);
+  }
+
+  std::shared_ptr<ZstdDictionary> dictionary_;
+  std::mutex mutex_;
+  std::vector<ZSTD_CCtx*> cctxs_;
+  std::vector<ZSTD_DCtx*> dctxs_;
+};
+
+/// \brief EXPERIMENTAL: Store a ZSTD dictionary in key-value metadata
+///
+/// Use on the metadata travelling with the compressed payloads (such as the
+/// schema metadata of an IPC stream) so that readers can rebuild the codec with
+/// ReadZstdDictionary().
+inline Status AttachZstdDictionary(const Buffer& dictionary, KeyValueMetadata* metadata) {
+  return metadata->Set(kZstdDictionaryMetadataKey,
+                       base64_encode(std::string_view(dictionary)));
+}
+
+namespace internal {
+
+// Whether `encoded` is padded base64 as written by base64_encode(), which
+// base64_decode() does not check
+inline bool IsValidBase64(std::string_view encoded) {
+  if (encoded.size() % 4 != 0) return false;
+  size_t padding = 0;
+  while (padding < 2 && padding < encoded.size() &&
+         encoded[encoded.size() - 1 - padding] == '=') {
+    ++padding;
+  }
+  for (size_t i = 0; i < encoded.size() - padding; ++i) {
+    const char c = encoded[i];
+    if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+          c == '+' || c == '/')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: Read a ZSTD dictionary stored by AttachZstdDictionary()
+///
+/// \return the dictionary, or null if `metadata` holds none
+inline Result<std::shared_ptr<Buffer>> ReadZstdDictionary(
+    const KeyValueMetadata& metadata) {
+  const int index = metadata.FindKey(kZstdDictionaryMetadataKey);
+  if (index < 0) {
+    return NULLPTR;
+  }
+  const std::string& encoded = metadata.value(index);
+  if (encoded.empty() || !internal::IsValidBase64(encoded)) {
+    return Status::Invalid("Invalid base64 in ZSTD dictionary metadata");
+  }
+  return Buffer::FromString(base64_decode(encoded));
+}
+
+}  // namespace util
+}  // namespace arrow
+
+#endif  // ARROW_HAVE_ZSTD_DICTIONARY
@@ -0,0 +1,118 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "arrow/io/interfaces.h"
+#include "arrow/record_batch.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/table.h"
+#include "arrow/util/byte_size.h"
+#include "parquet/arrow/writer.h"
+#include "parquet/platform.h"
+#include "parquet/properties.h"
+
+namespace parquet {
+namespace arrow {
+
+/// \brief Number of rows of `table` to put in a buffered row group
+///
+/// At most `max_rows`, and few enough that the row group's input data is
+/// estimated to fit in `memory_limit` bytes.  The estimate is the average size
+/// of a row of `table` in memory, as Arrow data: the encoded and compressed
+/// pages actually buffered by the writer are usually smaller, but may be
+/// larger for skewed rows.  Always at least one row.
+inline ::arrow::Result<int64_t> BufferedRowGroupLength(const ::arrow::Table& table,
+                                                       int64_t max_rows,
+                                                       int64_t memory_limit) {
+  if (table.num_rows() == 0 || memory_limit == std::numeric_limits<int64_t>::max()) {
+    return std::max<int64_t>(max_rows, 1);
+  }
+  ARROW_ASSIGN_OR_RAISE(const int64_t table_bytes,
+                        ::arrow::util::ReferencedBufferSize(table));
+  const int64_t row_bytes = std::max<int64_t>(table_bytes / table.num_rows(), 1);
+  return std::max<int64_t>(std::min(max_rows, memory_limit / row_bytes), 1);
+}
+
+/// \brief EXPERIMENTAL: Write a Table to Parquet, encoding and compressing
+/// the columns of each row group in parallel.
+///
+/// Unlike WriteTable(), which encodes one column chunk after another on the
+/// calling thread, this writes buffered row groups: the column chunks of a row
+/// group are encoded and compressed concurrently on
+/// ArrowWriterProperties::executor() (when use_threads() is enabled, as in the
+/// default `arrow_properties` here), buffered in memory, then written to `sink`
+/// in column order.  Row groups are sized to respect both `chunk_size` and
+/// `buffered_row_group_memory_limit`.
+///
+/// \param table Table to write.
+/// \param pool memory pool to use.
+/// \param sink output stream to write Parquet data.
+/// \param chunk_size maximum number of rows to write per row group.
+/// \param properties general Parquet writer properties.
+/// \param arrow_properties Arrow-specific writer properties.
+/// \param buffered_row_group_memory_limit approximate bound, in bytes, of the
+/// input data of a row group, see BufferedRowGroupLength().  Unbounded by
+/// default.
+inline ::arrow::Status WriteTableParallel(
+    const ::arrow::Table& table, MemoryPool* pool,
+    std::shared_ptr<::arrow::io::OutputStream> sink,
+    int64_t chunk_size = DEFAULT_MAX_ROW_GROUP_LENGTH,
+    std::shared_ptr<WriterProperties> properties = default_writer_properties(),
+    std::shared_ptr<ArrowWriterProperties> arrow_properties =
+        ArrowWriterProperties::Builder().set_use_threads(true)->build(),
+    int64_t buffered_row_group_memory_limit = std::numeric_limits<int64_t>::max()) {
+  if (chunk_size <= 0 && table.num_rows() > 0) {
+    return ::arrow::Status::Invalid("chunk size per row_group must be greater than 0");
+  }
+  const int64_t max_row_group_length = properties->max_row_group_length();
+  chunk_size = std::min(chunk_size, max_row_group_length);
+  ARROW_ASSIGN_OR_RAISE(
+      const int64_t row_group_length,
+      BufferedRowGroupLength(table, chunk_size, buffered_row_group_memory_limit));
+  ARROW_ASSIGN_OR_RAISE(auto writer,
+                        FileWriter::Open(*table.schema(), pool, std::move(sink),
+                                         std::move(properties), arrow_properties));
+  // WriteRecordBatch() starts a new buffered row group by itself whenever the
+  // current one reaches max_row_group_length(), so row groups are only
+  // delimited here when they must be shorter
+  const bool split = row_group_length < max_row_group_length;
+  const int64_t slice_length = split ? row_group_length : table.num_rows();
+  for (int64_t offset = 0; offset < table.num_rows(); offset += slice_length) {
+    if (split) {
+      RETURN_NOT_OK(writer->NewBufferedRowGroup());
+    }
+    ::arrow::TableBatchReader reader(table.Slice(offset, slice_length));
+    std::shared_ptr<::arrow::RecordBatch> batch;
+    while (true) {
+      RETURN_NOT_OK(reader.ReadNext(&batch));
+      if (batch == NULLPTR) break;
+      RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+    }
+  }
+  return writer->Close();
+}
+
+}  // namespace arrow
+}  // namespace parquet
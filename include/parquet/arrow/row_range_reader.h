@@ -0,0 +1,522 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Reading selected ranges of rows of a Parquet file as Arrow record batches
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "arrow/array/array_base.h"
+#include "arrow/array/concatenate.h"
+#include "arrow/array/data.h"
+#include "arrow/array/util.h"
+#include "arrow/buffer.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/io/memory.h"
+#include "arrow/record_batch.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/type.h"
+#include "arrow/type_traits.h"
+#include "arrow/util/bit_util.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/future.h"
+#include "parquet/arrow/schema.h"
+#include "parquet/column_reader.h"
+#include "parquet/exception.h"
+#include "parquet/file_reader.h"
+#include "parquet/metadata.h"
+#include "parquet/page_index.h"
+#include "parquet/platform.h"
+#include "parquet/properties.h"
+
+namespace parquet {
+namespace arrow {
+
+/// \brief A range of rows [start, start + length) of a Parquet file
+///
+/// Row numbers are counted from the start of the file, across row groups.
+struct RowRange {
+  int64_t start;
+  int64_t length;
+
+  int64_t end() const { return start + length; }
+};
+
+/// \brief EXPERIMENTAL: A RecordBatchReader over selected rows of a Parquet file
+///
+/// Unlike FileReader::GetRecordBatchReader(), which decodes whole row groups,
+/// this reader only fetches and decodes the data pages holding the requested
+/// rows.  Pages are located with the offset index of each column chunk (see
+/// WriterProperties::Builder::enable_write_page_index()), the pages around the
+/// requested ranges are read with a single coalesced request per run of
+/// adjacent pages, and the rows preceding a range inside its first page are
+/// skipped with RecordReader::SkipRecords().  The cost of a read is thus in
+/// proportion to the number of rows returned rather than to the size of the
+/// row groups.  Column chunks without an offset index, and encrypted ones, are
+/// read whole and skipped through.
+///
+/// Ranges are sorted and merged, so rows are returned in file order and at most
+/// once.  A batch holds at most ArrowReaderProperties::batch_size() rows and
+/// never spans two row groups or two disjoint ranges.
+///
+/// Only top-level, non-nested columns are supported, read as their plain
+/// (non-dictionary) Arrow type when that type shares the Parquet physical
+/// layout: boolean, 32- and 64-bit integers, floating point, temporal types,
+/// binary, string and fixed-size binary.  Other columns yield NotImplemented.
+class RowRangeRecordBatchReader : public ::arrow::RecordBatchReader {
+ public:
+  /// \brief Open a reader over `row_ranges` of the Parquet file `source`
+  ///
+  /// \param source the Parquet file
+  /// \param row_ranges rows to read, in any order
+  /// \param column_indices leaf columns to read (order determines output
+  ///     schema), or empty to read all columns
+  /// \param properties Parquet reader properties
+  /// \param arrow_properties Arrow reader properties; batch_size() and
+  ///     io_context() are used
+  /// \param metadata the file metadata, if already read
+  static ::arrow::Result<std::unique_ptr<RowRangeRecordBatchReader>> Make(
+      std::shared_ptr<::arrow::io::RandomAccessFile> source,
+      std::vector<RowRange> row_ranges, std::vector<int> column_indices = {},
+      const ReaderProperties& properties = default_reader_properties(),
+      const ArrowReaderProperties& arrow_properties = default_arrow_reader_properties(),
+      std::shared_ptr<FileMetaData> metadata = NULLPTR) {
+    std::unique_ptr<RowRangeRecordBatchReader> reader(new RowRangeRecordBatchReader(
+        std::move(source), properties, arrow_properties));
+    BEGIN_PARQUET_CATCH_EXCEPTIONS
+    RETURN_NOT_OK(reader->Init(std::move(row_ranges), std::move(column_indices),
+                               std::move(metadata)));
+    END_PARQUET_CATCH_EXCEPTIONS
+    return reader;
+  }
+
+  std::shared_ptr<::arrow::Schema> schema() const override { return schema_; }
+
+  ::arrow::Status ReadNext(std::shared_ptr<::arrow::RecordBatch>* out) override {
+    BEGIN_PARQUET_CATCH_EXCEPTIONS
+    return DoReadNext(out);
+    END_PARQUET_CATCH_EXCEPTIONS
+  }
+
+  /// \brief The number of column chunk bytes read from the file so far
+  ///
+  /// Only counts the pages selected through the offset index; column chunks
+  /// read whole are not included.
+  int64_t bytes_read() const { return bytes_read_; }
+
+ private:
+  // Rows of a row group, relative to its first row, to read from it
+  struct RowGroupPlan {
+    int row_group;
+    std::vector<RowRange> ranges;
+  };
+
+  struct ColumnState {
+    int column_index;
+    std::shared_ptr<::arrow::Field> field;
+    std::shared_ptr<::parquet::internal::RecordReader> record_reader;
+    // Rows of the current row group held by the pages given to the record
+    // reader, in order
+    std::vector<RowRange> decoded_rows;
+    // Number of records consumed from the record reader
+    int64_t position = 0;
+  };
+
+  RowRangeRecordBatchReader(std::shared_ptr<::arrow::io::RandomAccessFile> source,
+                            const ReaderProperties& properties,
+                            const ArrowReaderProperties& arrow_properties)
+      : source_(std::move(source)),
+        properties_(properties),
+        arrow_properties_(arrow_properties) {}
+
+  ::arrow::Status Init(std::vector<RowRange> row_ranges, std::vector<int> column_indices,
+                       std::shared_ptr<FileMetaData> metadata) {
+    if (arrow_properties_.batch_size() <= 0) {
+      return ::arrow::Status::Invalid("Batch size must be positive");
+    }
+    file_reader_ = ParquetFileReader::Open(source_, properties_, std::move(metadata));
+    const auto file_metadata = file_reader_->metadata();
+    const SchemaDescriptor* descr = file_metadata->schema();
+
+    SchemaManifest manifest;
+    RETURN_NOT_OK(SchemaManifest::Make(descr, file_metadata->key_value_metadata(),
+                                       arrow_properties_, &manifest));
+    if (column_indices.empty()) {
+      for (int i = 0; i < descr->num_columns(); ++i) column_indices.push_back(i);
+    }
+    ::arrow::FieldVector fields;
+    for (int i : column_indices) {
+      if (i < 0 || i >= descr->num_columns()) {
+        return ::arrow::Status::Invalid("Column index out of bounds: ", i);
+      }
+      const SchemaField* field;
+      RETURN_NOT_OK(manifest.GetColumnField(i, &field));
+      if (manifest.GetParent(field) != NULLPTR) {
+        return ::arrow::Status::NotImplemented(
+            "Reading nested column '", descr->Column(i)->path()->ToDotString(),
+            "' by row ranges");
+      }
+      ColumnState state;
+      state.column_index = i;
+      state.field = field->field;
+      state.record_reader = ::parquet::internal::RecordReader::Make(
+          descr->Column(i), field->level_info, arrow_properties_.io_context().pool());
+      columns_.push_back(std::move(state));
+      fields.push_back(field->field);
+    }
+    schema_ = ::arrow::schema(std::move(fields), manifest.schema_metadata);
+
+    RETURN_NOT_OK(PlanRowGroups(std::move(row_ranges)));
+
+    std::vector<int32_t> row_groups;
+    for (const auto& plan : plans_) row_groups.push_back(plan.row_group);
+    std::vector<int32_t> index_columns(column_indices.begin(), column_indices.end());
+    if (!row_groups.empty()) {
+      page_index_reader_ = file_reader_->GetPageIndexReader();
+    }
+    if (page_index_reader_ != NULLPTR) {
+      PageIndexSelection selection;
+      selection.offset_index = true;
+      page_index_reader_->WillNeed(row_groups, index_columns, selection);
+    }
+    return ::arrow::Status::OK();
+  }
+
+  // Normalize the requested ranges and split them across row groups
+  ::arrow::Status PlanRowGroups(std::vector<RowRange> row_ranges) {
+    const auto file_metadata = file_reader_->metadata();
+    for (const auto& range : row_ranges) {
+      if (range.start < 0 || range.length < 0 ||
+          range.end() > file_metadata->num_rows()) {
+        return ::arrow::Status::IndexError("Row range [", range.start, ", ",
+                                           range.end(), ") out of bounds for file of ",
+                                           file_metadata->num_rows(), " rows");
+      }
+    }
+    std::sort(row_ranges.begin(), row_ranges.end(),
+              [](const RowRange& a, const RowRange& b) { return a.start < b.start; });
+    std::vector<RowRange> merged;
+    for (const auto& range : row_ranges) {
+      if (range.length == 0) continue;
+      if (!merged.empty() && range.start <= merged.back().end()) {
+        merged.back().length =
+            std::max(merged.back().end(), range.end()) - merged.back().start;
+      } else {
+        merged.push_back(range);
+      }
+    }
+
+    int64_t row_group_start = 0;
+    auto range = merged.begin();
+    for (int i = 0; i < file_metadata->num_row_groups() && range != merged.end(); ++i) {
+      const int64_t row_group_end =
+          row_group_start + file_metadata->RowGroup(i)->num_rows();
+      RowGroupPlan plan{i, {}};
+      while (range != merged.end() && range->start < row_group_end) {
+        const int64_t start = std::max(range->start, row_group_start);
+        const int64_t end = std::min(range->end(), row_group_end);
+        plan.ranges.push_back({start - row_group_start, end - start});
+        if (range->end() > row_group_end) break;
+        ++range;
+      }
+      if (!plan.ranges.empty()) plans_.push_back(std::move(plan));
+      row_group_start = row_group_end;
+    }
+    return ::arrow::Status::OK();
+  }
+
+  ::arrow::Status DoReadNext(std::shared_ptr<::arrow::RecordBatch>* out) {
+    while (plan_index_ < plans_.size()) {
+      const RowGroupPlan& plan = plans_[plan_index_];
+      if (range_index_ == plan.ranges.size()) {
+        ++plan_index_;
+        range_index_ = 0;
+        row_group_started_ = false;
+        continue;
+      }
+      if (!row_group_started_) {
+        RETURN_NOT_OK(StartRowGroup(plan));
+        row_group_started_ = true;
+      }
+      const RowRange& range = plan.ranges[range_index_];
+      const int64_t num_rows =
+          std::min(arrow_properties_.batch_size(), range.length - range_offset_);
+      const int64_t row = range.start + range_offset_;
+      ::arrow::ArrayVector arrays;
+      for (auto& column : columns_) {
+        ARROW_ASSIGN_OR_RAISE(auto array, ReadColumn(&column, row, num_rows));
+        arrays.push_back(std::move(array));
+      }
+      range_offset_ += num_rows;
+      if (range_offset_ == range.length) {
+        ++range_index_;
+        range_offset_ = 0;
+      }
+      *out = ::arrow::RecordBatch::Make(schema_, num_rows, std::move(arrays));
+      return ::arrow::Status::OK();
+    }
+    if (page_index_reader_ != NULLPTR && !plans_.empty()) {
+      std::vector<int32_t> row_groups;
+      for (const auto& plan : plans_) row_groups.push_back(plan.row_group);
+      page_index_reader_->WillNotNeed(row_groups);
+      plans_.clear();
+    }
+    out->reset();
+    return ::arrow::Status::OK();
+  }
+
+  ::arrow::Status StartRowGroup(const RowGroupPlan& plan) {
+    const auto row_group_metadata = file_reader_->metadata()->RowGroup(plan.row_group);
+    const int64_t num_rows = row_group_metadata->num_rows();
+    auto row_group_reader = file_reader_->RowGroup(plan.row_group);
+    std::shared_ptr<RowGroupPageIndexReader> index_reader;
+    if (page_index_reader_ != NULLPTR) {
+      index_reader = page_index_reader_->RowGroup(plan.row_group);
+    }
+    for (auto& column : columns_) {
+      const auto chunk = row_group_metadata->ColumnChunk(column.column_index);
+      std::shared_ptr<OffsetIndex> offset_index;
+      if (index_reader != NULLPTR && chunk->crypto_metadata() == NULLPTR) {
+        offset_index = index_reader->GetOffsetIndex(column.column_index);
+      }
+      std::unique_ptr<PageReader> pages;
+      if (offset_index != NULLPTR) {
+        ARROW_ASSIGN_OR_RAISE(pages, OpenSelectedPages(*chunk, *offset_index, num_rows,
+                                                       plan.ranges, &column));
+      }
+      if (pages == NULLPTR) {
+        pages = row_group_reader->GetColumnPageReader(column.column_index);
+        column.decoded_rows = {{0, num_rows}};
+      }
+      column.record_reader->SetPageReader(std::move(pages));
+      column.position = 0;
+    }
+    return ::arrow::Status::OK();
+  }
+
+  // Open a PageReader over the dictionary page and the data pages of a column
+  // chunk that overlap `ranges`, or return null if the offset index is unusable
+  ::arrow::Result<std::unique_ptr<PageReader>> OpenSelectedPages(
+      const ColumnChunkMetaData& chunk, const OffsetIndex& offset_index,
+      int64_t row_group_rows, const std::vector<RowRange>& ranges,
+      ColumnState* column) {
+    const auto& locations = offset_index.page_locations();
+    if (locations.empty()) {
+      return NULLPTR;
+    }
+    std::vector<::arrow::io::ReadRange> reads;
+    if (chunk.has_dictionary_page()) {
+      const int64_t dictionary_offset = chunk.dictionary_page_offset();
+      if (dictionary_offset <= 0 || dictionary_offset >= locations[0].offset) {
+        return NULLPTR;
+      }
+      reads.push_back({dictionary_offset, locations[0].offset - dictionary_offset});
+    }
+    column->decoded_rows.clear();
+    int64_t num_values = 0;
+    auto range = ranges.begin();
+    for (size_t i = 0; i < locations.size(); ++i) {
+      const int64_t page_start = locations[i].first_row_index;
+      const int64_t page_end =
+          i + 1 < locations.size() ? locations[i + 1].first_row_index : row_group_rows;
+      while (range != ranges.end() && range->end() <= page_start) ++range;
+      if (range == ranges.end() || range->start >= page_end) continue;
+
+      // Non-repeated columns have one value (possibly null) per row
+      num_values += page_end - page_start;
+      auto& decoded = column->decoded_rows;
+      if (!decoded.empty() && decoded.back().end() == page_start) {
+        decoded.back().length += page_end - page_start;
+      } else {
+        decoded.push_back({page_start, page_end - page_start});
+      }
+      const ::arrow::io::ReadRange page{locations[i].offset,
+                                        locations[i].compressed_page_size};
+      if (!reads.empty() && reads.back().offset + reads.back().length == page.offset) {
+        reads.back().length += page.length;
+      } else {
+        reads.push_back(page);
+      }
+    }
+
+    // Submit the whole plan of the column chunk at once so that files with
+    // vectored reads can batch it
+    const auto& io_context = arrow_properties_.io_context();
+    auto futures = source_->ReadManyAsync(io_context, reads);
+    for (const auto& read : reads) bytes_read_ += read.length;
+    ::arrow::BufferVector buffers;
+    for (size_t i = 0; i < futures.size(); ++i) {
+      ARROW_ASSIGN_OR_RAISE(auto buffer, futures[i].result());
+      if (buffer->size() != reads[i].length) {
+        return ::arrow::Status::IOError("Unexpected end of file reading column chunk at ",
+                                        reads[i].offset);
+      }
+      buffers.push_back(std::move(buffer));
+    }
+    std::shared_ptr<::arrow::Buffer> data;
+    if (buffers.size() == 1) {
+      data = std::move(buffers[0]);
+    } else {
+      ARROW_ASSIGN_OR_RAISE(data,
+                            ::arrow::ConcatenateBuffers(buffers, io_context.pool()));
+    }
+    return PageReader::Open(std::make_shared<::arrow::io::BufferReader>(std::move(data)),
+                            num_values, chunk.compression(), properties_);
+  }
+
+  // Read `num_rows` rows of the current row group starting at `row`
+  ::arrow::Result<std::shared_ptr<::arrow::Array>> ReadColumn(ColumnState* column,
+                                                             int64_t row,
+                                                             int64_t num_rows) {
+    int64_t target = 0;
+    for (const auto& decoded : column->decoded_rows) {
+      if (row < decoded.end()) {
+        target += row - decoded.start;
+        break;
+      }
+      target += decoded.length;
+    }
+    ::parquet::internal::RecordReader* reader = column->record_reader.get();
+    if (target > column->position) {
+      const int64_t to_skip = target - column->position;
+      if (reader->SkipRecords(to_skip) != to_skip) {
+        return ::arrow::Status::IOError("Column chunk of '", column->field->name(),
+                                        "' has fewer rows than expected");
+      }
+    }
+    reader->Reset();
+    reader->Reserve(num_rows);
+    if (reader->ReadRecords(num_rows) != num_rows) {
+      return ::arrow::Status::IOError("Column chunk of '", column->field->name(),
+                                      "' has fewer rows than expected");
+    }
+    column->position = target + num_rows;
+    return TransferColumnData(*column, num_rows);
+  }
+
+  ::arrow::Result<std::shared_ptr<::arrow::Array>> TransferColumnData(
+      const ColumnState& column, int64_t num_rows) {
+    ::parquet::internal::RecordReader* reader = column.record_reader.get();
+    const auto& type = column.field->type();
+    const auto physical_type = reader->descr()->physical_type();
+    auto* pool = arrow_properties_.io_context().pool();
+    std::shared_ptr<::arrow::Buffer> validity;
+    if (reader->nullable_values() && reader->null_count() > 0) {
+      validity = reader->ReleaseIsValid();
+    }
+
+    switch (physical_type) {
+      case Type::BOOLEAN: {
+        if (type->id() != ::arrow::Type::BOOL) break;
+        // Booleans are decoded as one byte per value
+        ARROW_ASSIGN_OR_RAISE(auto values, ::arrow::AllocateEmptyBitmap(num_rows, pool));
+        const uint8_t* decoded = reader->values();
+        for (int64_t i = 0; i < num_rows; ++i) {
+          if (decoded[i]) ::arrow::bit_util::SetBit(values->mutable_data(), i);
+        }
+        return ::arrow::MakeArray(::arrow::ArrayData::Make(
+            type, num_rows, {std::move(validity), std::move(values)},
+            reader->null_count()));
+      }
+      case Type::INT32:
+      case Type::INT64:
+      case Type::FLOAT:
+      case Type::DOUBLE: {
+        const int bit_width =
+            (physical_type == Type::INT32 || physical_type == Type::FLOAT) ? 32 : 64;
+        if (!::arrow::is_primitive(type->id()) || type->id() == ::arrow::Type::BOOL ||
+            ::arrow::internal::checked_cast<const ::arrow::FixedWidthType&>(*type)
+                    .bit_width() != bit_width) {
+          break;
+        }
+        return ::arrow::MakeArray(::arrow::ArrayData::Make(
+            type, num_rows, {std::move(validity), reader->ReleaseValues()},
+            reader->null_count()));
+      }
+      case Type::BYTE_ARRAY:
+      case Type::FIXED_LEN_BYTE_ARRAY: {
+        const bool supported =
+            physical_type == Type::BYTE_ARRAY
+                ? (type->id() == ::arrow::Type::BINARY ||
+                   type->id() == ::arrow::Type::STRING)
+                : type->id() == ::arrow::Type::FIXED_SIZE_BINARY;
+        auto* binary_reader =
+            dynamic_cast<::parquet::internal::BinaryRecordReader*>(reader);
+        if (!supported || binary_reader == NULLPTR) break;
+        auto chunks = binary_reader->GetBuilderChunks();
+        std::shared_ptr<::arrow::Array> array;
+        if (chunks.size() == 1) {
+          array = std::move(chunks[0]);
+        } else {
+          ARROW_ASSIGN_OR_RAISE(array, ::arrow::Concatenate(chunks, pool));
+        }
+        if (!array->type()->Equals(*type)) {
+          auto data = array->data()->Copy();
+          data->type = type;
+          array = ::arrow::MakeArray(std::move(data));
+        }
+        return array;
+      }
+      default:
+        break;
+    }
+    return ::arrow::Status::NotImplemented("Reading column '", column.field->name(),
+                                           "' of type ", type->ToString(),
+                                           " by row ranges");
+  }
+
+  std::shared_ptr<::arrow::io::RandomAccessFile> source_;
+  ReaderProperties properties_;
+  ArrowReaderProperties arrow_properties_;
+  std::unique_ptr<ParquetFileReader> file_reader_;
+  std::shared_ptr<PageIndexReader> page_index_reader_;
+  std::shared_ptr<::arrow::Schema> schema_;
+  std::vector<ColumnState> columns_;
+  std::vector<RowGroupPlan> plans_;
+
+  size_t plan_index_ = 0;
+  size_t range_index_ = 0;
+  int64_t range_offset_ = 0;
+  bool row_group_started_ = false;
+  int64_t bytes_read_ = 0;
+};
+
+/// \brief EXPERIMENTAL: Return a RecordBatchReader over selected rows of a
+/// Parquet file
+///
+/// See RowRangeRecordBatchReader.
+inline ::arrow::Result<std::unique_ptr<::arrow::RecordBatchReader>> GetRecordBatchReader(
+    std::shared_ptr<::arrow::io::RandomAccessFile> source,
+    std::vector<RowRange> row_ranges, std::vector<int> column_indices = {},
+    const ReaderProperties& properties = default_reader_properties(),
+    const ArrowReaderProperties& arrow_properties = default_arrow_reader_properties()) {
+  ARROW_ASSIGN_OR_RAISE(
+      auto reader,
+      RowRangeRecordBatchReader::Make(std::move(source), std::move(row_ranges),
+                                      std::move(column_indices), properties,
+                                      arrow_properties));
+  return std::unique_ptr<::arrow::RecordBatchReader>(std::move(reader));
+}
+
+}  // namespace arrow
+}  // namespace parquet
@@ -0,0 +1,287 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arrow/array/array_binary.h"
+#include "arrow/array/array_dict.h"
+#include "arrow/array/util.h"
+#include "arrow/buffer.h"
+#include "arrow/chunked_array.h"
+#include "arrow/memory_pool.h"
+#include "arrow/result.h"
+#include "arrow/status.h"
+#include "arrow/type.h"
+#include "arrow/util/bitmap_ops.h"
+#include "arrow/util/checked_cast.h"
+#include "arrow/util/hashing.h"
+#include "arrow/util/simd.h"
+#include "parquet/platform.h"
+
+namespace parquet {
+namespace arrow {
+
+namespace internal {
+
+/// \brief Remap dictionary indices through `transpose_map`
+///
+/// out[i] = transpose_map[in[i]].  Indices outside [0, map_length), such as the
+/// undefined slots behind nulls, are mapped to 0 instead of being dereferenced.
+/// `in` and `out` may alias.
+inline void TransposeDictionaryIndices(const int32_t* in, int64_t length,
+                                       const int32_t* transpose_map, int32_t map_length,
+                                       int32_t* out) {
+  int64_t i = 0;
+#if defined(ARROW_HAVE_AVX2)
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i minus_one = _mm256_set1_epi32(-1);
+  const __m256i upper = _mm256_set1_epi32(map_length);
+  for (; i + 8 <= length; i += 8) {
+    const __m256i indices =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    const __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi32(indices, minus_one),
+                                              _mm256_cmpgt_epi32(upper, indices));
+    const __m256i transposed = _mm256_mask_i32gather_epi32(
+        zero, reinterpret_cast<const int*>(transpose_map), indices, in_range, 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), transposed);
+  }
+#endif
+  for (; i < length; ++i) {
+    const int32_t index = in[i];
+    out[i] = (index >= 0 && index < map_length) ? transpose_map[index] : 0;
+  }
+}
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: A dictionary shared by all chunks of a column
+///
+/// Chunk dictionaries (one per row group when reading with
+/// ArrowReaderProperties::set_read_dictionary) are merged into a single memo
+/// table and chunk indices are remapped onto it.  The dictionary only ever
+/// grows, so indices remapped earlier stay valid against any later snapshot,
+/// and every chunk can be given the final dictionary with Finish().
+///
+/// Only binary and string value types are supported, matching the column
+/// types DictionaryRecordReader produces.  This class is thread-safe.
+class StableDictionary {
+ public:
+  /// \brief Create a dictionary of `value_type` values, which must be binary
+  /// or string
+  static ::arrow::Result<std::shared_ptr<StableDictionary>> Make(
+      std::shared_ptr<::arrow::DataType> value_type,
+      ::arrow::MemoryPool* pool = ::arrow::default_memory_pool()) {
+    if (value_type->id() != ::arrow::Type::BINARY &&
+        value_type->id() != ::arrow::Type::STRING) {
+      return ::arrow::Status::TypeError("Stable dictionaries of type ",
+                                        value_type->ToString(),
+                                        " are not supported");
+    }
+    return std::shared_ptr<StableDictionary>(
+        new StableDictionary(std::move(value_type), pool));
+  }
+
+  const std::shared_ptr<::arrow::DataType>& value_type() const { return value_type_; }
+
+  /// \brief The number of distinct values seen so far
+  int32_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memo_table_.size();
+  }
+
+  /// \brief Merge a chunk dictionary
+  ///
+  /// On return, (*transpose_map)[i] is the stable index of dictionary.Value(i).
+  ::arrow::Status Insert(const ::arrow::Array& dictionary,
+                         std::vector<int32_t>* transpose_map) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return InsertUnlocked(dictionary, transpose_map);
+  }
+
+  /// \brief Remap a chunk onto the stable dictionary
+  ///
+  /// The returned array has the same int32 indices layout as `chunk` and
+  /// carries the dictionary snapshot taken after merging chunk.dictionary().
+  ::arrow::Result<std::shared_ptr<::arrow::Array>> Remap(
+      const ::arrow::DictionaryArray& chunk) {
+    const auto& dict_type =
+        ::arrow::internal::checked_cast<const ::arrow::DictionaryType&>(*chunk.type());
+    if (dict_type.index_type()->id() != ::arrow::Type::INT32) {
+      return ::arrow::Status::NotImplemented(
+          "Stable dictionaries require int32 indices, got ",
+          dict_type.index_type()->ToString());
+    }
+    if (!dict_type.value_type()->Equals(*value_type_)) {
+      return ::arrow::Status::TypeError("Cannot remap a chunk with ",
+                                        dict_type.value_type()->ToString(),
+                                        " values onto a stable dictionary of ",
+                                        value_type_->ToString());
+    }
+    std::vector<int32_t> transpose_map;
+    std::shared_ptr<::arrow::Array> dictionary;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ARROW_RETURN_NOT_OK(InsertUnlocked(*chunk.dictionary(), &transpose_map));
+      ARROW_ASSIGN_OR_RAISE(dictionary, SnapshotUnlocked());
+    }
+
+    const auto& indices = *chunk.indices()->data();
+    ARROW_ASSIGN_OR_RAISE(
+        auto out_indices,
+        ::arrow::AllocateBuffer(indices.length * sizeof(int32_t), pool_));
+    internal::TransposeDictionaryIndices(
+        indices.GetValues<int32_t>(1), indices.length, transpose_map.data(),
+        static_cast<int32_t>(transpose_map.size()),
+        reinterpret_cast<int32_t*>(out_indices->mutable_data()));
+
+    auto out_data = indices.Copy();
+    out_data->type = ::arrow::dictionary(::arrow::int32(), value_type_);
+    out_data->buffers = {indices.buffers[0], std::move(out_indices)};
+    out_data->offset = 0;
+    if (indices.offset != 0 && indices.buffers[0] != NULLPTR) {
+      // Keep the validity bitmap addressable from offset 0
+      ARROW_ASSIGN_OR_RAISE(out_data->buffers[0],
+                            ::arrow::internal::CopyBitmap(
+                                pool_, indices.buffers[0]->data(), indices.offset,
+                                indices.length));
+    }
+    out_data->dictionary = dictionary->data();
+    return ::arrow::MakeArray(std::move(out_data));
+  }
+
+  /// \brief A snapshot of the dictionary in its current state
+  ::arrow::Result<std::shared_ptr<::arrow::Array>> GetDictionary() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SnapshotUnlocked();
+  }
+
+  /// \brief Attach the current dictionary to chunks returned by Remap()
+  ///
+  /// No index is touched: this only swaps the dictionary pointer, so all chunks
+  /// of the result compare equal in type and dictionary.
+  ::arrow::Result<std::shared_ptr<::arrow::ChunkedArray>> Finish(
+      const ::arrow::ChunkedArray& remapped) {
+    ARROW_ASSIGN_OR_RAISE(auto dictionary, GetDictionary());
+    ::arrow::ArrayVector chunks;
+    chunks.reserve(remapped.num_chunks());
+    for (const auto& chunk : remapped.chunks()) {
+      auto data = chunk->data()->Copy();
+      data->dictionary = dictionary->data();
+      chunks.push_back(::arrow::MakeArray(std::move(data)));
+    }
+    return std::make_shared<::arrow::ChunkedArray>(
+        std::move(chunks), ::arrow::dictionary(::arrow::int32(), value_type_));
+  }
+
+ private:
+  StableDictionary(std::shared_ptr<::arrow::DataType> value_type,
+                   ::arrow::MemoryPool* pool)
+      : value_type_(std::move(value_type)), pool_(pool), memo_table_(pool) {}
+
+  ::arrow::Status InsertUnlocked(const ::arrow::Array& dictionary,
+                                 std::vector<int32_t>* transpose_map) {
+    if (!dictionary.type()->Equals(*value_type_)) {
+      return ::arrow::Status::TypeError("Cannot merge a dictionary of ",
+                                        dictionary.type()->ToString(),
+                                        " into a stable dictionary of ",
+                                        value_type_->ToString());
+    }
+    if (dictionary.null_count() != 0) {
+      return ::arrow::Status::NotImplemented(
+          "Stable dictionaries with null dictionary values");
+    }
+    const auto& values =
+        ::arrow::internal::checked_cast<const ::arrow::BinaryArray&>(dictionary);
+    transpose_map->resize(values.length());
+    for (int64_t i = 0; i < values.length(); ++i) {
+      ARROW_RETURN_NOT_OK(
+          memo_table_.GetOrInsert(values.GetView(i), &(*transpose_map)[i]));
+    }
+    return ::arrow::Status::OK();
+  }
+
+  ::arrow::Result<std::shared_ptr<::arrow::Array>> SnapshotUnlocked() {
+    const int32_t length = memo_table_.size();
+    if (snapshot_ != NULLPTR && snapshot_->length() == length) {
+      return snapshot_;
+    }
+    ARROW_ASSIGN_OR_RAISE(
+        auto offsets, ::arrow::AllocateBuffer((length + 1) * sizeof(int32_t), pool_));
+    ARROW_ASSIGN_OR_RAISE(auto data,
+                          ::arrow::AllocateBuffer(memo_table_.values_size(), pool_));
+    memo_table_.CopyOffsets(reinterpret_cast<int32_t*>(offsets->mutable_data()));
+    memo_table_.CopyValues(data->mutable_data());
+    snapshot_ = ::arrow::MakeArray(::arrow::ArrayData::Make(
+        value_type_, length, {NULLPTR, std::move(offsets), std::move(data)},
+        /*null_count=*/0));
+    return snapshot_;
+  }
+
+  std::shared_ptr<::arrow::DataType> value_type_;
+  ::arrow::MemoryPool* pool_;
+  mutable std::mutex mutex_;
+  ::arrow::internal::BinaryMemoTable<::arrow::BinaryBuilder> memo_table_;
+  std::shared_ptr<::arrow::Array> snapshot_;
+};
+
+/// \brief EXPERIMENTAL: Stable dictionaries for the columns of a dataset
+///
+/// Pass the dictionary-encoded chunks read from all files of a dataset through
+/// the StableDictionary of their column so that the column keeps one dictionary
+/// across row groups and files.  Columns are keyed by their dotted path.
+///
+/// The compiled FileReader does not use this class: callers remap the chunks it
+/// returns themselves.  This class is thread-safe.
+class StableDictionaryMemo {
+ public:
+  explicit StableDictionaryMemo(
+      ::arrow::MemoryPool* pool = ::arrow::default_memory_pool())
+      : pool_(pool) {}
+
+  /// \brief Return the dictionary of `column_path`, creating it if needed
+  ::arrow::Result<std::shared_ptr<StableDictionary>> GetOrCreate(
+      const std::string& column_path,
+      const std::shared_ptr<::arrow::DataType>& value_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = dictionaries_.find(column_path);
+    if (it == dictionaries_.end()) {
+      ARROW_ASSIGN_OR_RAISE(auto dictionary, StableDictionary::Make(value_type, pool_));
+      it = dictionaries_.emplace(column_path, std::move(dictionary)).first;
+    } else if (!it->second->value_type()->Equals(*value_type)) {
+      return ::arrow::Status::TypeError("Column '", column_path, "' was read as ",
+                                        it->second->value_type()->ToString(),
+                                        " and now as ", value_type->ToString());
+    }
+    return it->second;
+  }
+
+ private:
+  ::arrow::MemoryPool* pool_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<StableDictionary>> dictionaries_;
+};
+
+}  // namespace arrow
+}  // namespace parquet
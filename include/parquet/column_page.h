@@ -26,6 +26,7 @@
 #include <optional>
 #include <string>
 
+#include "arrow/buffer.h"
 #include "parquet/statistics.h"
 #include "parquet/types.h"
 
@@ -168,4 +169,66 @@ class DictionaryPage : public Page {
   bool is_sorted_;
 };
 
+namespace internal {
+
+/// \brief Return the PLAIN-encoded values of a data page as a slice of its buffer
+///
+/// This is possible when the page holds the values exactly as an Arrow array
+/// would: PLAIN encoding of a 4- or 8-byte fixed-width physical type (INT32,
+/// INT64, FLOAT, DOUBLE), no definition or repetition levels (a required,
+/// non-nested column) and no compression.  When the column chunk is read from a
+/// MemoryMappedFile with buffered streams disabled, the page buffer is itself a
+/// slice of the mapping and the returned buffer references the mapped file
+/// directly.
+///
+/// Returns null if any of these conditions does not hold, or if the values are
+/// not aligned to their width.
+///
+/// The compiled column readers do not call this function and always copy the
+/// values; it is meant for callers consuming pages from a PageReader directly.
+/// The returned buffer keeps the page buffer, hence the mapping, alive.
+inline std::shared_ptr<Buffer> ZeroCopyPlainValues(const DataPage& page,
+                                                   Type::type physical_type,
+                                                   int16_t max_definition_level,
+                                                   int16_t max_repetition_level,
+                                                   Compression::type compression) {
+  int64_t value_width;
+  switch (physical_type) {
+    case Type::INT32:
+    case Type::FLOAT:
+      value_width = 4;
+      break;
+    case Type::INT64:
+    case Type::DOUBLE:
+      value_width = 8;
+      break;
+    default:
+      return NULLPTR;
+  }
+  if (page.encoding() != Encoding::PLAIN || max_definition_level != 0 ||
+      max_repetition_level != 0 || compression != Compression::UNCOMPRESSED) {
+    return NULLPTR;
+  }
+  const std::shared_ptr<Buffer>& buffer = page.buffer();
+  if (buffer == NULLPTR || !buffer->is_cpu()) {
+    return NULLPTR;
+  }
+  int64_t values_offset = 0;
+  if (page.type() == PageType::DATA_PAGE_V2) {
+    const auto& page_v2 = static_cast<const DataPageV2&>(page);
+    values_offset = page_v2.definition_levels_byte_length() +
+                    page_v2.repetition_levels_byte_length();
+  }
+  const int64_t values_size = static_cast<int64_t>(page.num_values()) * value_width;
+  if (values_offset + values_size > buffer->size()) {
+    return NULLPTR;
+  }
+  const auto address = reinterpret_cast<uintptr_t>(buffer->data() + values_offset);
+  if (address % value_width != 0) {
+    return NULLPTR;
+  }
+  return ::arrow::SliceBuffer(buffer, values_offset, values_size);
+}
+
+}  // namespace internal
 }  // namespace parquet
@@ -0,0 +1,179 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Cost model for choosing the encoding of a column chunk from sampled pages
+
+// This API is EXPERIMENTAL.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "parquet/metadata.h"
+#include "parquet/types.h"
+
+namespace parquet {
+
+/// \brief EXPERIMENTAL: Objective of adaptive encoding selection.
+///
+/// Callers encode the first `sample_pages` data pages of a column chunk with
+/// each candidate encoding applicable to the column's physical type (see
+/// internal::AdaptiveEncodingCandidates()), optionally combined with each of
+/// `compression_levels`, and keep the cheapest combination, as ranked by
+/// internal::SelectEncoding(), for the rest of the column chunk.  The cost of a
+/// candidate is
+///
+///   size_weight * (compressed size / PLAIN size)
+///     + (1 - size_weight) * (decode cost / PLAIN decode cost)
+///
+/// This is a standalone helper: the column writer of this library does not
+/// sample pages nor call it, so the chosen encoding must be set explicitly
+/// through WriterProperties::Builder::encoding().
+struct AdaptiveEncodingProperties {
+  /// \brief Weight in [0, 1] of the file size in the objective.
+  ///
+  /// 1 optimizes for the smallest file, 0 for the fastest decoding.
+  double size_weight = 0.5;
+  /// \brief Number of leading data pages of a column chunk to sample
+  int32_t sample_pages = 1;
+  /// \brief Compression levels to try in addition to the column's own level
+  ///
+  /// Empty means only the column's configured compression level is used.
+  std::vector<int> compression_levels;
+};
+
+namespace internal {
+
+/// \brief Outcome of encoding the sampled pages with one candidate
+struct EncodingTrial {
+  Encoding::type encoding;
+  int compression_level;
+  /// Size of the sampled pages with this candidate, after compression
+  int64_t encoded_bytes;
+  /// Size of the same values with PLAIN encoding, before compression
+  int64_t plain_bytes;
+};
+
+/// \brief The data page encodings worth trying for a physical type
+///
+/// The dictionary candidate is reported as RLE_DICTIONARY; the writer falls back
+/// from it like it does for a statically configured dictionary.
+inline std::vector<Encoding::type> AdaptiveEncodingCandidates(Type::type physical_type,
+                                                              bool dictionary_enabled) {
+  std::vector<Encoding::type> candidates;
+  if (dictionary_enabled && physical_type != Type::BOOLEAN) {
+    candidates.push_back(Encoding::RLE_DICTIONARY);
+  }
+  switch (physical_type) {
+    case Type::INT32:
+    case Type::INT64:
+      candidates.push_back(Encoding::DELTA_BINARY_PACKED);
+      break;
+    case Type::FLOAT:
+    case Type::DOUBLE:
+      // The format and this library only allow BYTE_STREAM_SPLIT for FLOAT and
+      // DOUBLE, even though the kernels in byte_stream_split.h handle any width
+      candidates.push_back(Encoding::BYTE_STREAM_SPLIT);
+      break;
+    case Type::BYTE_ARRAY:
+      candidates.push_back(Encoding::DELTA_LENGTH_BYTE_ARRAY);
+      candidates.push_back(Encoding::DELTA_BYTE_ARRAY);
+      break;
+    default:
+      break;
+  }
+  candidates.push_back(Encoding::PLAIN);
+  return candidates;
+}
+
+/// \brief Decode cost of an encoding relative to PLAIN
+///
+/// Coarse figures taken from the encoding benchmarks; only their ordering
+/// matters for the selection.
+inline double RelativeDecodeCost(Encoding::type encoding) {
+  switch (encoding) {
+    case Encoding::PLAIN:
+      return 1.0;
+    case Encoding::BYTE_STREAM_SPLIT:
+      return 1.5;
+    case Encoding::PLAIN_DICTIONARY:
+    case Encoding::RLE_DICTIONARY:
+      return 2.0;
+    case Encoding::DELTA_BINARY_PACKED:
+    case Encoding::DELTA_LENGTH_BYTE_ARRAY:
+      return 2.5;
+    case Encoding::DELTA_BYTE_ARRAY:
+      return 4.0;
+    default:
+      return 1.0;
+  }
+}
+
+/// \brief Cost of a trial under the objective set in `properties`
+inline double AdaptiveEncodingCost(const EncodingTrial& trial,
+                                   const AdaptiveEncodingProperties& properties) {
+  const double size_ratio = trial.plain_bytes > 0
+                                ? static_cast<double>(trial.encoded_bytes) /
+                                      static_cast<double>(trial.plain_bytes)
+                                : 1.0;
+  return properties.size_weight * size_ratio +
+         (1.0 - properties.size_weight) * RelativeDecodeCost(trial.encoding);
+}
+
+/// \brief Pick the cheapest trial, or nullptr if `trials` is empty
+///
+/// Ties are resolved in favour of the earliest trial, so callers should list
+/// trials in AdaptiveEncodingCandidates() order.
+inline const EncodingTrial* SelectEncoding(const std::vector<EncodingTrial>& trials,
+                                           const AdaptiveEncodingProperties& properties) {
+  const EncodingTrial* best = NULLPTR;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (const auto& trial : trials) {
+    const double cost = AdaptiveEncodingCost(trial, properties);
+    if (cost < best_cost) {
+      best = &trial;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
+}  // namespace internal
+
+/// \brief The encoding used by most data pages of a column chunk
+///
+/// Returns Encoding::UNKNOWN if the metadata carries no page
+/// encoding statistics.
+inline Encoding::type DataPageEncoding(const ColumnChunkMetaData& metadata) {
+  Encoding::type encoding = Encoding::UNKNOWN;
+  int32_t max_count = 0;
+  for (const auto& stats : metadata.encoding_stats()) {
+    if (stats.page_type != PageType::DATA_PAGE &&
+        stats.page_type != PageType::DATA_PAGE_V2) {
+      continue;
+    }
+    if (stats.count > max_count) {
+      encoding = stats.encoding;
+      max_count = stats.count;
+    }
+  }
+  return encoding;
+}
+
+}  // namespace parquet
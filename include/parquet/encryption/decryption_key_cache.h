@@ -0,0 +1,224 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "parquet/encryption/crypto_factory.h"
+#include "parquet/encryption/encryption.h"
+#include "parquet/encryption/key_metadata.h"
+#include "parquet/encryption/kms_client.h"
+#include "parquet/encryption/two_level_cache_with_expiration.h"
+#include "parquet/platform.h"
+
+namespace parquet {
+namespace encryption {
+
+/// \brief EXPERIMENTAL: Cache of data encryption keys shared by the readers of
+/// many files
+///
+/// Readers retrieve the key of every encrypted column of every file they open
+/// from its key metadata, which with the key management tools means parsing
+/// the key material and unwrapping the data key with a key encryption key (or
+/// a KMS call in single wrapping mode).  In datasets of many files sharing the
+/// same keys, this cache returns the keys already retrieved for the same key
+/// metadata instead.
+///
+/// Entries are scoped by access token, like the caches of KeyToolkit, so that
+/// a key retrieved with one token is never served to a reader with another, and
+/// expire after `cache_lifetime_seconds`.  Keys are zeroed when evicted.  This
+/// class is thread-safe; retrieval of missing keys happens outside of the lock.
+///
+/// Only the data keys are cached.  The reader still creates the Decryptor of
+/// every column, with its own AES-GCM/CTR cipher contexts, for each file it
+/// opens; those are not pooled.
+class DecryptionKeyCache {
+ public:
+  explicit DecryptionKeyCache(
+      double cache_lifetime_seconds = kDefaultCacheLifetimeSeconds)
+      : cache_lifetime_seconds_(cache_lifetime_seconds),
+        last_cleanup_(internal::CurrentTimePoint()) {}
+
+  ~DecryptionKeyCache() { RemoveCacheEntriesForAllTokens(); }
+
+  double cache_lifetime_seconds() const { return cache_lifetime_seconds_; }
+
+  /// \brief Return the key for `key_metadata`, retrieving it with `retriever`
+  /// if it is not cached for `access_token`
+  std::string GetOrRetrieve(const std::string& access_token,
+                            const std::string& key_metadata,
+                            DecryptionKeyRetriever* retriever) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto token_entries = entries_.find(access_token);
+      if (token_entries != entries_.end()) {
+        auto entry = token_entries->second.find(key_metadata);
+        if (entry != token_entries->second.end()) {
+          if (internal::CurrentTimePoint() <= entry->second.expiration) {
+            return entry->second.key;
+          }
+          Wipe(&entry->second.key);
+          token_entries->second.erase(entry);
+        }
+      }
+    }
+
+    std::string key = retriever->GetKey(key_metadata);
+    const auto now = internal::CurrentTimePoint();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (now > last_cleanup_ + std::chrono::duration<double>(cache_lifetime_seconds_)) {
+      RemoveExpiredEntriesNoMutex(now);
+      last_cleanup_ = now;
+    }
+    auto& entry = entries_[access_token][key_metadata];
+    Wipe(&entry.key);
+    entry.key = key;
+    entry.expiration = now + std::chrono::duration<double>(cache_lifetime_seconds_);
+    return key;
+  }
+
+  /// \brief Flush the keys retrieved with the (compromised) access token
+  void RemoveCacheEntriesForToken(const std::string& access_token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto token_entries = entries_.find(access_token);
+    if (token_entries != entries_.end()) {
+      for (auto& entry : token_entries->second) Wipe(&entry.second.key);
+      entries_.erase(token_entries);
+    }
+  }
+
+  void RemoveCacheEntriesForAllTokens() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& token_entries : entries_) {
+      for (auto& entry : token_entries.second) Wipe(&entry.second.key);
+    }
+    entries_.clear();
+  }
+
+  /// \brief The number of cached keys, expired or not
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t size = 0;
+    for (const auto& token_entries : entries_) size += token_entries.second.size();
+    return size;
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    internal::TimePoint expiration;
+  };
+
+  static void Wipe(std::string* key) { std::fill(key->begin(), key->end(), '\0'); }
+
+  void RemoveExpiredEntriesNoMutex(internal::TimePoint now) {
+    for (auto token_entries = entries_.begin(); token_entries != entries_.end();) {
+      auto& keys = token_entries->second;
+      for (auto entry = keys.begin(); entry != keys.end();) {
+        if (now > entry->second.expiration) {
+          Wipe(&entry->second.key);
+          entry = keys.erase(entry);
+        } else {
+          ++entry;
+        }
+      }
+      token_entries = keys.empty() ? entries_.erase(token_entries) : ++token_entries;
+    }
+  }
+
+  const double cache_lifetime_seconds_;
+  mutable std::mutex mutex_;
+  internal::TimePoint last_cleanup_;
+  // access token -> key metadata -> key
+  std::unordered_map<std::string, std::unordered_map<std::string, Entry>> entries_;
+};
+
+/// \brief EXPERIMENTAL: A DecryptionKeyRetriever looking keys up in a
+/// DecryptionKeyCache before delegating to another retriever
+///
+/// The cache is only correct if the same key metadata designates the same key
+/// in every file sharing it.  This holds for key metadata embedding the key
+/// material, as written by the key management tools with internal key material,
+/// or for metadata naming keys of a fixed key store; it does not hold for
+/// references to external key material, which are only unique within a file.
+/// With `internal_key_material_only`, key metadata is parsed as KeyMetadata
+/// and only keys with internal key material are cached.
+class CachingDecryptionKeyRetriever : public DecryptionKeyRetriever {
+ public:
+  CachingDecryptionKeyRetriever(std::shared_ptr<DecryptionKeyCache> cache,
+                                std::shared_ptr<DecryptionKeyRetriever> retriever,
+                                std::string access_token = "",
+                                bool internal_key_material_only = false)
+      : cache_(std::move(cache)),
+        retriever_(std::move(retriever)),
+        access_token_(std::move(access_token)),
+        internal_key_material_only_(internal_key_material_only) {}
+
+  std::string GetKey(const std::string& key_metadata) override {
+    if (internal_key_material_only_ &&
+        !KeyMetadata::Parse(key_metadata).key_material_stored_internally()) {
+      return retriever_->GetKey(key_metadata);
+    }
+    return cache_->GetOrRetrieve(access_token_, key_metadata, retriever_.get());
+  }
+
+ private:
+  std::shared_ptr<DecryptionKeyCache> cache_;
+  std::shared_ptr<DecryptionKeyRetriever> retriever_;
+  const std::string access_token_;
+  const bool internal_key_material_only_;
+};
+
+/// \brief EXPERIMENTAL: Get decryption properties for a Parquet file, sharing
+/// the data keys of files already opened through `cache`
+///
+/// Same as CryptoFactory::GetFileDecryptionProperties(), except that data keys
+/// with internal key material are looked up in `cache`, under the access token
+/// of `kms_connection_config`, before being unwrapped.  Use one cache for all
+/// the files of a dataset.
+///
+/// This saves the key material parsing and key unwrapping only; decryptors and
+/// cipher contexts are still created per file and column by the reader.
+inline std::shared_ptr<FileDecryptionProperties> GetCachedFileDecryptionProperties(
+    CryptoFactory* crypto_factory, const std::shared_ptr<DecryptionKeyCache>& cache,
+    const KmsConnectionConfig& kms_connection_config,
+    const DecryptionConfiguration& decryption_config, const std::string& file_path = "",
+    const std::shared_ptr<::arrow::fs::FileSystem>& file_system = NULLPTR) {
+  auto properties = crypto_factory->GetFileDecryptionProperties(
+      kms_connection_config, decryption_config, file_path, file_system);
+  FileDecryptionProperties::Builder builder;
+  builder.key_retriever(std::make_shared<CachingDecryptionKeyRetriever>(
+      cache, properties->key_retriever(), kms_connection_config.key_access_token(),
+      /*internal_key_material_only=*/true));
+  if (properties->plaintext_files_allowed()) {
+    builder.plaintext_files_allowed();
+  }
+  if (!properties->check_plaintext_footer_integrity()) {
+    builder.disable_footer_signature_verification();
+  }
+  return builder.build();
+}
+
+}  // namespace encryption
+}  // namespace parquet
@@ -0,0 +1,440 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Column-projected footer deserialization for very wide files.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/buffer.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/util/endian.h"
+#include "arrow/util/ubsan.h"
+#include "parquet/exception.h"
+#include "parquet/file_writer.h"
+#include "parquet/metadata.h"
+#include "parquet/platform.h"
+#include "parquet/properties.h"
+
+namespace parquet {
+namespace internal {
+
+/// \brief Minimal reader of the Thrift compact protocol
+///
+/// Only walks the message: values are skipped rather than materialized, which
+/// is what makes indexing a footer much cheaper than deserializing it.
+class ThriftCompactScanner {
+ public:
+  enum Type : uint8_t {
+    kStop = 0,
+    kBoolTrue = 1,
+    kBoolFalse = 2,
+    kByte = 3,
+    kI16 = 4,
+    kI32 = 5,
+    kI64 = 6,
+    kDouble = 7,
+    kBinary = 8,
+    kList = 9,
+    kSet = 10,
+    kMap = 11,
+    kStruct = 12,
+  };
+
+  static constexpr int kMaxDepth = 64;
+
+  ThriftCompactScanner(const uint8_t* data, int64_t size, int32_t string_size_limit,
+                       int32_t container_size_limit)
+      : data_(data),
+        size_(size),
+        string_size_limit_(string_size_limit),
+        container_size_limit_(container_size_limit) {}
+
+  int64_t position() const { return position_; }
+
+  uint8_t ReadByte() {
+    if (ARROW_PREDICT_FALSE(position_ >= size_)) {
+      throw ParquetException("Couldn't deserialize thrift: unexpected end of message");
+    }
+    return data_[position_++];
+  }
+
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      const uint8_t byte = ReadByte();
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw ParquetException("Couldn't deserialize thrift: invalid varint");
+  }
+
+  int64_t ReadZigZag() {
+    const uint64_t value = ReadVarint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  /// \brief Read the header of the next field of a struct
+  ///
+  /// \return false on the struct's STOP marker
+  bool ReadFieldHeader(int16_t* last_field_id, int16_t* field_id, uint8_t* type) {
+    const uint8_t byte = ReadByte();
+    if (byte == kStop) {
+      return false;
+    }
+    *type = byte & 0x0f;
+    const int delta = byte >> 4;
+    *field_id = delta != 0 ? static_cast<int16_t>(*last_field_id + delta)
+                           : static_cast<int16_t>(ReadZigZag());
+    *last_field_id = *field_id;
+    return true;
+  }
+
+  void ReadListHeader(uint8_t* element_type, int64_t* size) {
+    const uint8_t byte = ReadByte();
+    *element_type = byte & 0x0f;
+    *size = byte >> 4;
+    if (*size == 15) {
+      *size = static_cast<int64_t>(ReadVarint());
+    }
+    CheckContainerSize(*size);
+  }
+
+  /// \brief Skip a value of the given type
+  ///
+  /// `in_container` tells whether the value is a list, set or map element, where
+  /// booleans take one byte instead of being folded into the field header.
+  void Skip(uint8_t type, bool in_container = false, int depth = 0) {
+    if (ARROW_PREDICT_FALSE(depth > kMaxDepth)) {
+      throw ParquetException("Couldn't deserialize thrift: nesting too deep");
+    }
+    switch (type) {
+      case kBoolTrue:
+      case kBoolFalse:
+        if (in_container) ReadByte();
+        break;
+      case kByte:
+        ReadByte();
+        break;
+      case kI16:
+      case kI32:
+      case kI64:
+        ReadVarint();
+        break;
+      case kDouble:
+        Advance(8);
+        break;
+      case kBinary: {
+        const auto length = static_cast<int64_t>(ReadVarint());
+        if (ARROW_PREDICT_FALSE(length > string_size_limit_)) {
+          throw ParquetException("Couldn't deserialize thrift: string size ", length,
+                                 " exceeds limit ", string_size_limit_);
+        }
+        Advance(length);
+        break;
+      }
+      case kList:
+      case kSet: {
+        uint8_t element_type;
+        int64_t size;
+        ReadListHeader(&element_type, &size);
+        for (int64_t i = 0; i < size; ++i) {
+          Skip(element_type, /*in_container=*/true, depth + 1);
+        }
+        break;
+      }
+      case kMap: {
+        const auto size = static_cast<int64_t>(ReadVarint());
+        CheckContainerSize(size);
+        if (size == 0) break;
+        const uint8_t types = ReadByte();
+        for (int64_t i = 0; i < size; ++i) {
+          Skip(types >> 4, /*in_container=*/true, depth + 1);
+          Skip(types & 0x0f, /*in_container=*/true, depth + 1);
+        }
+        break;
+      }
+      case kStruct: {
+        int16_t last_field_id = 0;
+        int16_t field_id;
+        uint8_t field_type;
+        while (ReadFieldHeader(&last_field_id, &field_id, &field_type)) {
+          Skip(field_type, /*in_container=*/false, depth + 1);
+        }
+        break;
+      }
+      default:
+        throw ParquetException("Couldn't deserialize thrift: invalid type ",
+                               static_cast<int>(type));
+    }
+  }
+
+ private:
+  void Advance(int64_t length) {
+    if (ARROW_PREDICT_FALSE(length < 0 || length > size_ - position_)) {
+      throw ParquetException("Couldn't deserialize thrift: unexpected end of message");
+    }
+    position_ += length;
+  }
+
+  void CheckContainerSize(int64_t size) {
+    if (ARROW_PREDICT_FALSE(size < 0 || size > container_size_limit_)) {
+      throw ParquetException("Couldn't deserialize thrift: container size ", size,
+                             " exceeds limit ", container_size_limit_);
+    }
+  }
+
+  const uint8_t* data_;
+  const int64_t size_;
+  const int32_t string_size_limit_;
+  const int32_t container_size_limit_;
+  int64_t position_ = 0;
+};
+
+}  // namespace internal
+
+/// \brief EXPERIMENTAL: A file footer indexed but not yet deserialized
+///
+/// FileMetaData::Make() decodes the metadata of every column chunk, which for
+/// files with tens of thousands of columns can cost more than reading the data
+/// of the few columns a query needs.  This class only locates the column chunks
+/// in the serialized footer; Project() then decodes the metadata of the
+/// requested columns and replaces all other column chunks with empty
+/// placeholders before handing the footer to FileMetaData::Make().
+///
+/// Footers of files with encryption are not supported.
+class LazyFileMetaData {
+ public:
+  /// \brief Index a serialized plaintext footer (without the trailing length
+  /// and magic bytes)
+  static std::shared_ptr<LazyFileMetaData> Make(
+      std::shared_ptr<::arrow::Buffer> serialized_metadata,
+      const ReaderProperties& properties = default_reader_properties()) {
+    std::shared_ptr<LazyFileMetaData> metadata(
+        new LazyFileMetaData(std::move(serialized_metadata), properties));
+    metadata->Index();
+    return metadata;
+  }
+
+  const std::shared_ptr<::arrow::Buffer>& serialized_metadata() const {
+    return serialized_metadata_;
+  }
+
+  int num_row_groups() const { return static_cast<int>(row_groups_.size()); }
+
+  /// \brief The number of leaf columns, or 0 if the file has no row groups
+  int num_columns() const {
+    return row_groups_.empty() ? 0 : static_cast<int>(row_groups_[0].size());
+  }
+
+  /// \brief Deserialize the footer with only `column_indices` fully decoded
+  ///
+  /// The schema, key-value metadata and row group metadata are complete.  The
+  /// ColumnChunkMetaData of any column not in `column_indices` is empty (no
+  /// statistics, encodings or page offsets), so only the projected columns may
+  /// be read from, or filtered on, with the returned metadata.  Pass it to
+  /// ParquetFileReader::Open() to open the file without parsing its footer
+  /// again.
+  std::shared_ptr<FileMetaData> Project(const std::vector<int>& column_indices) const {
+    std::vector<bool> projected(num_columns(), false);
+    for (int index : column_indices) {
+      if (index < 0 || index >= num_columns()) {
+        throw ParquetException("Column index ", index, " out of range for ",
+                               num_columns(), " columns");
+      }
+      projected[index] = true;
+    }
+
+    const uint8_t* data = serialized_metadata_->data();
+    std::string out;
+    out.reserve(static_cast<size_t>(serialized_metadata_->size()));
+    int64_t position = 0;
+    for (const auto& columns : row_groups_) {
+      for (size_t i = 0; i < columns.size(); ++i) {
+        if (projected[i]) continue;
+        out.append(reinterpret_cast<const char*>(data) + position,
+                   static_cast<size_t>(columns[i].begin - position));
+        AppendPlaceholder(columns[i].file_offset, &out);
+        position = columns[i].end;
+      }
+    }
+    out.append(reinterpret_cast<const char*>(data) + position,
+               static_cast<size_t>(serialized_metadata_->size() - position));
+
+    auto length = static_cast<uint32_t>(out.size());
+    return FileMetaData::Make(out.data(), &length, properties_);
+  }
+
+ private:
+  // Byte range of a serialized ColumnChunk struct
+  struct ColumnChunkRange {
+    int64_t begin;
+    int64_t end;
+    int64_t file_offset;
+  };
+
+  // FileMetaData, RowGroup and ColumnChunk field ids, see parquet.thrift
+  static constexpr int16_t kFileMetaDataRowGroups = 4;
+  static constexpr int16_t kFileMetaDataEncryptionAlgorithm = 8;
+  static constexpr int16_t kRowGroupColumns = 1;
+  static constexpr int16_t kColumnChunkFileOffset = 2;
+
+  LazyFileMetaData(std::shared_ptr<::arrow::Buffer> serialized_metadata,
+                   const ReaderProperties& properties)
+      : serialized_metadata_(std::move(serialized_metadata)), properties_(properties) {}
+
+  void Index() {
+    using Scanner = internal::ThriftCompactScanner;
+    Scanner scanner(serialized_metadata_->data(), serialized_metadata_->size(),
+                    properties_.thrift_string_size_limit(),
+                    properties_.thrift_container_size_limit());
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t type;
+    while (scanner.ReadFieldHeader(&last_field_id, &field_id, &type)) {
+      if (field_id == kFileMetaDataEncryptionAlgorithm) {
+        ParquetException::NYI("lazy deserialization of encrypted file metadata");
+      }
+      if (field_id != kFileMetaDataRowGroups || type != Scanner::kList) {
+        scanner.Skip(type);
+        continue;
+      }
+      uint8_t element_type;
+      int64_t num_row_groups;
+      scanner.ReadListHeader(&element_type, &num_row_groups);
+      ExpectStruct(element_type);
+      row_groups_.resize(static_cast<size_t>(num_row_groups));
+      for (auto& columns : row_groups_) {
+        IndexRowGroup(&scanner, &columns);
+      }
+    }
+    for (const auto& columns : row_groups_) {
+      if (columns.size() != row_groups_[0].size()) {
+        throw ParquetException("Row groups have different numbers of columns");
+      }
+    }
+  }
+
+  static void IndexRowGroup(internal::ThriftCompactScanner* scanner,
+                            std::vector<ColumnChunkRange>* columns) {
+    using Scanner = internal::ThriftCompactScanner;
+    int16_t last_field_id = 0;
+    int16_t field_id;
+    uint8_t type;
+    while (scanner->ReadFieldHeader(&last_field_id, &field_id, &type)) {
+      if (field_id != kRowGroupColumns || type != Scanner::kList) {
+        scanner->Skip(type);
+        continue;
+      }
+      uint8_t element_type;
+      int64_t num_columns;
+      scanner->ReadListHeader(&element_type, &num_columns);
+      ExpectStruct(element_type);
+      columns->resize(static_cast<size_t>(num_columns));
+      for (auto& column : *columns) {
+        column.begin = scanner->position();
+        column.file_offset = 0;
+        int16_t last_column_field_id = 0;
+        while (scanner->ReadFieldHeader(&last_column_field_id, &field_id, &type)) {
+          if (field_id == kColumnChunkFileOffset && type == Scanner::kI64) {
+            column.file_offset = scanner->ReadZigZag();
+          } else {
+            scanner->Skip(type);
+          }
+        }
+        column.end = scanner->position();
+      }
+    }
+  }
+
+  static void ExpectStruct(uint8_t element_type) {
+    if (element_type != internal::ThriftCompactScanner::kStruct) {
+      throw ParquetException("Couldn't deserialize thrift: expected a list of structs");
+    }
+  }
+
+  // A ColumnChunk holding only its required file_offset field
+  static void AppendPlaceholder(int64_t file_offset, std::string* out) {
+    out->push_back(static_cast<char>((kColumnChunkFileOffset << 4) |
+                                     internal::ThriftCompactScanner::kI64));
+    uint64_t value =
+        (static_cast<uint64_t>(file_offset) << 1) ^ static_cast<uint64_t>(file_offset >> 63);
+    while (value >= 0x80) {
+      out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+    out->push_back(static_cast<char>(internal::ThriftCompactScanner::kStop));
+  }
+
+  std::shared_ptr<::arrow::Buffer> serialized_metadata_;
+  ReaderProperties properties_;
+  std::vector<std::vector<ColumnChunkRange>> row_groups_;
+};
+
+/// \brief EXPERIMENTAL: Read the footer of a file without deserializing it
+///
+/// Use LazyFileMetaData::Project() to decode the metadata needed to read a
+/// subset of the columns.
+inline std::shared_ptr<LazyFileMetaData> ReadLazyMetaData(
+    const std::shared_ptr<::arrow::io::RandomAccessFile>& source,
+    const ReaderProperties& properties = default_reader_properties()) {
+  constexpr int64_t kFooterSize = 8;
+  PARQUET_ASSIGN_OR_THROW(const int64_t file_size, source->GetSize());
+  if (file_size < kFooterSize + static_cast<int64_t>(sizeof(kParquetMagic))) {
+    throw ParquetInvalidOrCorruptedFileException(
+        "Parquet file size is ", file_size,
+        " bytes, smaller than the minimum file footer (", kFooterSize, " bytes)");
+  }
+  PARQUET_ASSIGN_OR_THROW(auto footer,
+                          source->ReadAt(file_size - kFooterSize, kFooterSize));
+  if (footer->size() != kFooterSize) {
+    ParquetException::EofException("reading the file footer");
+  }
+  if (std::memcmp(footer->data() + 4, kParquetEMagic, 4) == 0) {
+    ParquetException::NYI("lazy deserialization of encrypted file metadata");
+  }
+  if (std::memcmp(footer->data() + 4, kParquetMagic, 4) != 0) {
+    throw ParquetInvalidOrCorruptedFileException(
+        "Parquet magic bytes not found in footer. Either the file is corrupted or "
+        "this is not a parquet file.");
+  }
+  const auto metadata_len = static_cast<int64_t>(
+      ::arrow::bit_util::FromLittleEndian(::arrow::util::SafeLoadAs<uint32_t>(
+          footer->data())));
+  if (metadata_len > file_size - kFooterSize) {
+    throw ParquetInvalidOrCorruptedFileException(
+        "Parquet file size is ", file_size,
+        " bytes, smaller than the size reported by footer's (", metadata_len, " bytes)");
+  }
+  PARQUET_ASSIGN_OR_THROW(
+      auto metadata, source->ReadAt(file_size - kFooterSize - metadata_len, metadata_len));
+  if (metadata->size() != metadata_len) {
+    ParquetException::EofException("reading the file metadata");
+  }
+  return LazyFileMetaData::Make(std::move(metadata), properties);
+}
+
+}  // namespace parquet
@@ -0,0 +1,211 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Batched reconstruction of list offsets and validity from def/rep levels
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+#include "arrow/util/bit_util.h"
+#include "arrow/util/bitmap_writer.h"
+#include "arrow/util/simd.h"
+#include "parquet/exception.h"
+#include "parquet/level_comparison.h"
+#include "parquet/level_conversion.h"
+
+namespace parquet {
+namespace internal {
+
+namespace batched {
+
+static constexpr int64_t kBatchSize = 64;
+
+// Gather the bits of `bitmap` selected by `select_bitmap` into the low bits
+inline uint64_t ExtractBits(uint64_t bitmap, uint64_t select_bitmap) {
+#if defined(ARROW_HAVE_BMI2) && UINTPTR_MAX != 0xFFFFFFFF
+  return _pext_u64(bitmap, select_bitmap);
+#else
+  uint64_t bit_value = 0;
+  int bit_len = 0;
+  while (select_bitmap != 0) {
+    const int bit = ::arrow::bit_util::CountTrailingZeros(select_bitmap);
+    bit_value |= ((bitmap >> bit) & 1) << bit_len;
+    ++bit_len;
+    select_bitmap &= select_bitmap - 1;
+  }
+  return bit_value;
+#endif
+}
+
+// Mask of the bits in [begin, end), with end <= 64
+inline uint64_t BitRangeMask(int64_t begin, int64_t end) {
+  const uint64_t below_end =
+      end == 64 ? ~uint64_t{0} : ::arrow::bit_util::LeastSignificantBitMask(end);
+  return below_end & ~::arrow::bit_util::LeastSignificantBitMask(begin);
+}
+
+/// Reconstructs list offsets and the list validity bitmap from def/rep levels,
+/// kBatchSize levels at a time.
+///
+/// Produces the same output as the scalar loop behind DefRepLevelsToList(), but
+/// instead of branching on every level it compares whole batches of levels into
+/// bitmaps with GreaterThanBitmap() (which the library dispatches to its SIMD
+/// kernels) and then only walks the positions where a list starts.  Levels
+/// belonging to deeper nested children are filtered out by the bitmaps, so the
+/// cost of deeply nested schemas grows with the number of lists rather than
+/// the number of leaf values.
+///
+/// `offsets` may be null when only the validity bitmap is needed (structs whose
+/// members all have a list descendant).
+template <typename OffsetType>
+void DefRepLevelsToListInfo(const int16_t* def_levels, const int16_t* rep_levels,
+                            int64_t num_def_levels, LevelInfo level_info,
+                            ValidityBitmapInputOutput* output, OffsetType* offsets) {
+  std::optional<::arrow::internal::FirstTimeBitmapWriter> valid_bits_writer;
+  if (output->valid_bits) {
+    valid_bits_writer.emplace(output->valid_bits, output->valid_bits_offset,
+                              output->values_read_upper_bound);
+  }
+  OffsetType* orig_pos = offsets;
+  int64_t lists_read = 0;
+
+  while (num_def_levels > 0) {
+    const int64_t batch_size = std::min(num_def_levels, kBatchSize);
+    // Levels of lists whose ancestors are non-empty
+    const uint64_t present = GreaterThanBitmap(
+        def_levels, batch_size, level_info.repeated_ancestor_def_level - 1);
+    // Levels of deeper nested children
+    const uint64_t nested =
+        GreaterThanBitmap(rep_levels, batch_size, level_info.rep_level);
+    // Continuations of this list or deeper nested children
+    const uint64_t not_start =
+        GreaterThanBitmap(rep_levels, batch_size, level_info.rep_level - 1);
+    const uint64_t relevant = present & ~nested;
+    const uint64_t starts = relevant & ~not_start;
+    const int64_t num_starts = ::arrow::bit_util::PopCount(starts);
+
+    lists_read += num_starts;
+    if (ARROW_PREDICT_FALSE(lists_read > output->values_read_upper_bound)) {
+      std::stringstream ss;
+      ss << "Definition levels exceeded upper bound: "
+         << output->values_read_upper_bound;
+      throw ParquetException(ss.str());
+    }
+
+    if (offsets != NULLPTR) {
+      // A list element is either a continuation, or a list start whose element
+      // is present (as opposed to an empty list).
+      const uint64_t elements =
+          (relevant & not_start) |
+          (starts & GreaterThanBitmap(def_levels, batch_size, level_info.def_level - 1));
+      uint64_t remaining_starts = starts;
+      int64_t segment_begin = 0;
+      while (true) {
+        // Elements up to the next list start extend the current list
+        const int64_t segment_end =
+            remaining_starts == 0
+                ? 64
+                : ::arrow::bit_util::CountTrailingZeros(remaining_starts);
+        const auto num_elements = static_cast<OffsetType>(::arrow::bit_util::PopCount(
+            elements & BitRangeMask(segment_begin, segment_end)));
+        if (ARROW_PREDICT_FALSE(*offsets >
+                                std::numeric_limits<OffsetType>::max() - num_elements)) {
+          throw ParquetException("List index overflow.");
+        }
+        *offsets += num_elements;
+        if (remaining_starts == 0) break;
+        ++offsets;
+        *offsets = *(offsets - 1);
+        segment_begin = segment_end;
+        remaining_starts &= remaining_starts - 1;
+      }
+    }
+
+    if (valid_bits_writer.has_value()) {
+      // The list def level reflects element presence, the prior level
+      // distinguishes empty lists from null lists.
+      const uint64_t valid_bits = ExtractBits(
+          GreaterThanBitmap(def_levels, batch_size, level_info.def_level - 2), starts);
+      valid_bits_writer->AppendWord(valid_bits, num_starts);
+      output->null_count += num_starts - ::arrow::bit_util::PopCount(valid_bits);
+    }
+
+    def_levels += batch_size;
+    rep_levels += batch_size;
+    num_def_levels -= batch_size;
+  }
+
+  if (valid_bits_writer.has_value()) {
+    valid_bits_writer->Finish();
+  }
+  if (offsets != NULLPTR) {
+    output->values_read = offsets - orig_pos;
+  } else if (valid_bits_writer.has_value()) {
+    output->values_read = valid_bits_writer->position();
+  }
+  if (output->null_count > 0 && level_info.null_slot_usage > 1) {
+    throw ParquetException(
+        "Null values with null_slot_usage > 1 not supported."
+        "(i.e. FixedSizeLists with null values are not supported)");
+  }
+}
+
+}  // namespace batched
+
+/// \brief EXPERIMENTAL: Drop-in replacement of DefRepLevelsToList() processing
+/// levels in batches of 64, see batched::DefRepLevelsToListInfo()
+inline void DefRepLevelsToListBatched(const int16_t* def_levels,
+                                      const int16_t* rep_levels, int64_t num_def_levels,
+                                      LevelInfo level_info,
+                                      ValidityBitmapInputOutput* output,
+                                      int32_t* offsets) {
+  batched::DefRepLevelsToListInfo<int32_t>(def_levels, rep_levels, num_def_levels,
+                                           level_info, output, offsets);
+}
+
+/// \brief EXPERIMENTAL: Drop-in replacement of DefRepLevelsToList() processing
+/// levels in batches of 64, see batched::DefRepLevelsToListInfo()
+inline void DefRepLevelsToListBatched(const int16_t* def_levels,
+                                      const int16_t* rep_levels, int64_t num_def_levels,
+                                      LevelInfo level_info,
+                                      ValidityBitmapInputOutput* output,
+                                      int64_t* offsets) {
+  batched::DefRepLevelsToListInfo<int64_t>(def_levels, rep_levels, num_def_levels,
+                                           level_info, output, offsets);
+}
+
+/// \brief EXPERIMENTAL: Drop-in replacement of DefRepLevelsToBitmap()
+/// processing levels in batches of 64
+inline void DefRepLevelsToBitmapBatched(const int16_t* def_levels,
+                                        const int16_t* rep_levels,
+                                        int64_t num_def_levels, LevelInfo level_info,
+                                        ValidityBitmapInputOutput* output) {
+  // The list reconstruction treats the struct as a list one level up
+  level_info.rep_level += 1;
+  level_info.def_level += 1;
+  batched::DefRepLevelsToListInfo<int32_t>(def_levels, rep_levels, num_def_levels,
+                                           level_info, output, /*offsets=*/NULLPTR);
+}
+
+}  // namespace internal
+}  // namespace parquet
@@ -0,0 +1,336 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "arrow/filesystem/filesystem.h"
+#include "arrow/util/hash_util.h"
+#include "parquet/bloom_filter.h"
+#include "parquet/metadata.h"
+#include "parquet/page_index.h"
+#include "parquet/platform.h"
+
+namespace parquet {
+
+/// \brief Identifies one version of a file in a FileMetadataCache
+///
+/// A file rewritten in place gets a different modification time (and usually a
+/// different size) and hence misses the cache instead of returning stale
+/// metadata.  Keys whose size or modification time is unknown cannot tell
+/// versions apart, e.g. a file rewritten at the same size, and are never
+/// cached.
+struct FileMetadataCacheKey {
+  /// The filesystem the path belongs to, e.g. its type_name().  Callers reading
+  /// from several filesystems of the same type (such as object stores at
+  /// different endpoints) should make it more specific.
+  std::string filesystem;
+  std::string path;
+  int64_t size = -1;
+  /// Modification time in nanoseconds since the epoch, -1 if unknown
+  int64_t mtime_ns = -1;
+
+  /// \brief Make a key from a file listing entry of `filesystem`
+  static FileMetadataCacheKey FromFileInfo(const ::arrow::fs::FileSystem& filesystem,
+                                           const ::arrow::fs::FileInfo& info) {
+    FileMetadataCacheKey key;
+    key.filesystem = filesystem.type_name();
+    key.path = info.path();
+    key.size = info.size();
+    if (info.mtime() != ::arrow::fs::kNoTime) {
+      key.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         info.mtime().time_since_epoch())
+                         .count();
+    }
+    return key;
+  }
+
+  /// \brief Whether the key identifies a version of the file
+  bool cacheable() const { return size >= 0 && mtime_ns >= 0; }
+
+  bool operator==(const FileMetadataCacheKey& other) const {
+    return filesystem == other.filesystem && path == other.path &&
+           size == other.size && mtime_ns == other.mtime_ns;
+  }
+
+  struct Hash {
+    size_t operator()(const FileMetadataCacheKey& key) const {
+      size_t h = std::hash<std::string>()(key.filesystem);
+      ::arrow::internal::hash_combine(h, key.path);
+      ::arrow::internal::hash_combine(h, key.size);
+      ::arrow::internal::hash_combine(h, key.mtime_ns);
+      return h;
+    }
+  };
+};
+
+/// \brief EXPERIMENTAL: Size-bounded LRU cache of parsed Parquet footers
+///
+/// Caches the parsed FileMetaData of files, along with the column indexes,
+/// offset indexes and bloom filters read for them, so that opening the same
+/// file again skips both the footer I/O and the Thrift decoding.  Entries are
+/// evicted per file, least recently used first, once the total charge exceeds
+/// the capacity.  Charges are estimated from the serialized sizes of the
+/// cached structures.
+///
+/// The compiled readers do not consult the cache: pass the metadata returned by
+/// GetOrLoadMetadata() to ParquetFileReader::Open().  The same instance may be
+/// shared by any number of readers and threads.  Lookups with keys that are not
+/// cacheable() always miss, and insertions with them are ignored.
+class FileMetadataCache {
+ public:
+  static constexpr int64_t kDefaultCapacity = 256 * 1024 * 1024;
+
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t evictions = 0;
+  };
+
+  explicit FileMetadataCache(int64_t capacity_bytes = kDefaultCapacity)
+      : capacity_(capacity_bytes) {}
+
+  /// \brief The process-wide cache instance
+  static const std::shared_ptr<FileMetadataCache>& Default() {
+    static const std::shared_ptr<FileMetadataCache> instance =
+        std::make_shared<FileMetadataCache>();
+    return instance;
+  }
+
+  int64_t capacity() const { return capacity_; }
+
+  /// \brief Total charge of the cached entries
+  int64_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  /// \brief Return the cached metadata of a file, or null
+  std::shared_ptr<FileMetaData> GetMetadata(const FileMetadataCacheKey& key) {
+    if (!key.cacheable()) return NULLPTR;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = Lookup(key);
+    if (entry == NULLPTR || entry->metadata == NULLPTR) {
+      ++stats_.misses;
+      return NULLPTR;
+    }
+    ++stats_.hits;
+    return entry->metadata;
+  }
+
+  /// \brief Return the cached metadata of a file, parsing it with `load` on a miss
+  ///
+  /// `load` is invoked without holding the cache lock; concurrent misses on the
+  /// same key may each parse the footer, and the last one wins.
+  ::arrow::Result<std::shared_ptr<FileMetaData>> GetOrLoadMetadata(
+      const FileMetadataCacheKey& key,
+      const std::function<::arrow::Result<std::shared_ptr<FileMetaData>>()>& load) {
+    auto metadata = GetMetadata(key);
+    if (metadata != NULLPTR) {
+      return metadata;
+    }
+    ARROW_ASSIGN_OR_RAISE(metadata, load());
+    PutMetadata(key, metadata);
+    return metadata;
+  }
+
+  void PutMetadata(const FileMetadataCacheKey& key,
+                   std::shared_ptr<FileMetaData> metadata) {
+    if (!key.cacheable()) return;
+    const int64_t charge = static_cast<int64_t>(metadata->size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrInsert(key);
+    Charge(entry, charge - (entry->metadata
+                                ? static_cast<int64_t>(entry->metadata->size())
+                                : 0));
+    entry->metadata = std::move(metadata);
+    EvictIfNeeded();
+  }
+
+  std::shared_ptr<ColumnIndex> GetColumnIndex(const FileMetadataCacheKey& key,
+                                              int row_group, int column) {
+    return GetComponent(key, &Entry::column_indexes, row_group, column);
+  }
+
+  void PutColumnIndex(const FileMetadataCacheKey& key, int row_group, int column,
+                      std::shared_ptr<ColumnIndex> index) {
+    int64_t charge = static_cast<int64_t>(index->null_pages().size()) +
+                     static_cast<int64_t>(index->null_counts().size() * sizeof(int64_t));
+    for (const auto& value : index->encoded_min_values()) charge += value.size();
+    for (const auto& value : index->encoded_max_values()) charge += value.size();
+    PutComponent(key, &Entry::column_indexes, row_group, column, std::move(index),
+                 charge);
+  }
+
+  std::shared_ptr<OffsetIndex> GetOffsetIndex(const FileMetadataCacheKey& key,
+                                              int row_group, int column) {
+    return GetComponent(key, &Entry::offset_indexes, row_group, column);
+  }
+
+  void PutOffsetIndex(const FileMetadataCacheKey& key, int row_group, int column,
+                      std::shared_ptr<OffsetIndex> index) {
+    const auto charge =
+        static_cast<int64_t>(index->page_locations().size() * sizeof(PageLocation));
+    PutComponent(key, &Entry::offset_indexes, row_group, column, std::move(index),
+                 charge);
+  }
+
+  std::shared_ptr<BloomFilter> GetBloomFilter(const FileMetadataCacheKey& key,
+                                              int row_group, int column) {
+    return GetComponent(key, &Entry::bloom_filters, row_group, column);
+  }
+
+  void PutBloomFilter(const FileMetadataCacheKey& key, int row_group, int column,
+                      std::shared_ptr<BloomFilter> filter) {
+    const int64_t charge = filter->GetBitsetSize();
+    PutComponent(key, &Entry::bloom_filters, row_group, column, std::move(filter),
+                 charge);
+  }
+
+  /// \brief Drop everything cached for a file
+  void Erase(const FileMetadataCacheKey& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      size_ -= it->second->charge;
+      lru_.erase(it->second);
+      index_.erase(it);
+    }
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    size_ = 0;
+  }
+
+ private:
+  using ComponentKey = std::pair<int, int>;
+
+  struct Entry {
+    FileMetadataCacheKey key;
+    int64_t charge = 0;
+    std::shared_ptr<FileMetaData> metadata;
+    std::map<ComponentKey, std::shared_ptr<ColumnIndex>> column_indexes;
+    std::map<ComponentKey, std::shared_ptr<OffsetIndex>> offset_indexes;
+    std::map<ComponentKey, std::shared_ptr<BloomFilter>> bloom_filters;
+  };
+  using EntryList = std::list<Entry>;
+
+  template <typename T>
+  std::shared_ptr<T> GetComponent(
+      const FileMetadataCacheKey& key,
+      std::map<ComponentKey, std::shared_ptr<T>> Entry::*components, int row_group,
+      int column) {
+    if (!key.cacheable()) return NULLPTR;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = Lookup(key);
+    if (entry != NULLPTR) {
+      auto it = (entry->*components).find({row_group, column});
+      if (it != (entry->*components).end()) {
+        ++stats_.hits;
+        return it->second;
+      }
+    }
+    ++stats_.misses;
+    return NULLPTR;
+  }
+
+  template <typename T>
+  void PutComponent(const FileMetadataCacheKey& key,
+                    std::map<ComponentKey, std::shared_ptr<T>> Entry::*components,
+                    int row_group, int column, std::shared_ptr<T> value,
+                    int64_t charge) {
+    if (!key.cacheable()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrInsert(key);
+    auto inserted = (entry->*components).emplace(ComponentKey{row_group, column}, value);
+    if (!inserted.second) {
+      // Replacing an existing component: its charge is unknown, keep the old one.
+      inserted.first->second = std::move(value);
+      return;
+    }
+    Charge(entry, charge);
+    EvictIfNeeded();
+  }
+
+  // Find an entry and mark it as most recently used
+  Entry* Lookup(const FileMetadataCacheKey& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return NULLPTR;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return &*it->second;
+  }
+
+  Entry* FindOrInsert(const FileMetadataCacheKey& key) {
+    Entry* entry = Lookup(key);
+    if (entry == NULLPTR) {
+      lru_.emplace_front();
+      lru_.front().key = key;
+      index_.emplace(key, lru_.begin());
+      entry = &lru_.front();
+      Charge(entry, static_cast<int64_t>(sizeof(Entry) + key.filesystem.size() +
+                                         key.path.size()));
+    }
+    return entry;
+  }
+
+  void Charge(Entry* entry, int64_t charge) {
+    entry->charge += charge;
+    size_ += charge;
+  }
+
+  void EvictIfNeeded() {
+    // Never evict the most recently used entry, even if it alone exceeds capacity
+    while (size_ > capacity_ && lru_.size() > 1) {
+      Entry& victim = lru_.back();
+      size_ -= victim.charge;
+      index_.erase(victim.key);
+      lru_.pop_back();
+      ++stats_.evictions;
+    }
+  }
+
+  const int64_t capacity_;
+  mutable std::mutex mutex_;
+  int64_t size_ = 0;
+  Stats stats_;
+  EntryList lru_;
+  std::unordered_map<FileMetadataCacheKey, EntryList::iterator,
+                     FileMetadataCacheKey::Hash>
+      index_;
+};
+
+}  // namespace parquet